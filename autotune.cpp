@@ -0,0 +1,294 @@
+// ==================================================================================
+// Name        : autotune.cpp
+// Author      : Felix Baessler
+// Version     : 17.10.2026
+// Copyright   : Felix Baessler, felix.baessler@gmail.com
+// SEE TLDR; VERSION OF THE LICENSE: https://creativecommons.org/licenses/by-nc/4.0/legalcode
+// SEE FULL LICENSE DETAILS HERE   : https://creativecommons.org/licenses/by-nc/4.0/
+//
+// Description :
+// Autotune calibrates the machine profile of scatter and gather by short passes on the target machine:
+// -	huge pages  : random probes of a calibration map, malloc versus transparent huge pages
+// -	prefetch    : random probes with the map slots prefetched PREFETCH_DISTANCE shingles ahead
+// -	batch size and thread layout : hash thread and probe thread handing over batches
+//		through three containers, as worker2 and worker3 do (stage by stage)
+// The best profile is written to v1_profile.h, included by scatter and gather
+// when they are compiled in the same directory.
+// The pipeline has a fixed number of threads (one hash, one probe thread): the layout sweep
+// places them on the logical processors (affinity masks).
+// ==================================================================================
+
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <random>
+#include <vector>
+#include <cstring>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+#include "mingw.thread.h"
+#include "mingw.mutex.h"
+#include "mingw.condition_variable.h"
+using namespace std;
+// time measurement
+using Time = std::chrono::time_point<std::chrono::high_resolution_clock>;
+Time start_timer() {
+    return std::chrono::high_resolution_clock::now();
+}
+double get_elapsed_time(Time start) {
+    Time end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> d = end - start;
+    std::chrono::microseconds us = std::chrono::duration_cast<std::chrono::microseconds>(d);
+    return us.count() / 1000.0f;
+}
+
+// calibration parameters
+#define CAL_MAP_SIZE  (1ULL << 30)		// calibration map [bytes] (scatter and gather: M_COM + M_DIV)
+#define CAL_SHINGLES  (4ULL << 20)		// shingles per calibration pass
+#define CAL_OCCUPANCY  0.625			// occupancy of the calibration map (about 1 - 1/e: ns == M_COM)
+#define L    5
+#define DV   8
+#define M_DIV   67ULL
+#define B_COM   257ULL
+const uint32_t batch_sizes[]= {2*1024, 4*1024, 8*1024, 16*1024, 32*1024, 64*1024};
+const uint32_t prefetch_distances[]= {0, 2, 4, 8, 16, 32, 64};
+// output
+const string profile_file_name= "v1_profile.h";
+
+uint8_t *map;
+uint64_t m_com;		// common hashes of the calibration map
+
+uint8_t *alloc_map(uint64_t size, bool huge) {
+#ifdef __linux__
+	if (huge) {
+		const uint64_t huge_page= 1ULL << 21;
+		uint64_t length= (size + huge_page - 1) / huge_page * huge_page;
+		uint8_t *p= (uint8_t *)aligned_alloc(huge_page, length);
+		if (p != NULL) madvise(p, length, MADV_HUGEPAGE);
+		return(p);
+	}
+#endif
+	return((uint8_t *)malloc(size));
+}
+
+void fill_map(mt19937 &mt_rand) {
+	// random bitmap: a bit stays set with probability 1/2 * 3/4 (occupancy 5/8)
+	mt19937_64 mt_rand_64(mt_rand());
+	for (uint64_t i= 0; i < m_com + M_DIV; i+= 8) {
+		uint64_t w= mt_rand_64() & (mt_rand_64() | mt_rand_64());
+		memcpy(map + i, &w, min((uint64_t)8, (uint64_t)(m_com + M_DIV - i)));
+	}
+}
+
+void hash_batch(const uint8_t s[], uint32_t hash_count, uint32_t com_hash[], uint8_t div_hash[][64*1024]) {
+	// Rabin-Karp with the moduli of scatter and gather (cost of worker2)
+	for (uint32_t j= 0; j < hash_count; j++) {
+		uint64_t h= 0;
+		uint32_t d= 0;
+		for (uint32_t k= 0; k < L; k++) {
+			h= h * B_COM + s[j+k];
+			d= d * 31 + s[j+k];
+		}
+		com_hash[j]= h % m_com;
+		for (uint8_t id= 0; id < DV; id++) div_hash[id][j]= (d >> id) % M_DIV;
+	}
+}
+
+uint32_t probe_batch(const uint32_t com_hash[], uint8_t div_hash[][64*1024], uint32_t hash_count, uint32_t distance) {
+	// bitmap probes with prefetch distance (cost of worker3), returns the number of hits
+	uint32_t hits= 0;
+	for (uint32_t j= 0; j < hash_count; j++) {
+		if (distance > 0 && j + distance < hash_count) {
+			__builtin_prefetch (&map[com_hash[j + distance]], 0, 3);
+			__builtin_prefetch (&map[com_hash[j + distance] + M_DIV - 1], 0, 3);
+		}
+		uint8_t w= 0;
+		for (uint8_t id= 0; id < DV; id++) w |= map[com_hash[j] + div_hash[id][j]] & (1<<id);
+		hits+= (w == 0);
+	}
+	return(hits);
+}
+
+// containers of the pipeline pass
+struct container {
+	vector<uint8_t>  buf;
+	vector<uint32_t> com;
+	uint8_t (*div)[64*1024];
+};
+
+double pipeline_pass(uint32_t batch_size, uint32_t distance, uint64_t hash_mask, uint64_t probe_mask, mt19937 &mt_rand) {
+	// [nanoseconds per shingle]: the hash thread fills container (b % 3), the probe thread probes container (b-1) % 3
+	container ctr[3];
+	for (uint32_t c= 0; c < 3; c++) {
+		ctr[c].buf.resize(batch_size + L + 3);
+		ctr[c].com.resize(batch_size);
+		ctr[c].div= new uint8_t[DV][64*1024];
+	}
+	uint32_t batch_count= CAL_SHINGLES / batch_size;
+	mutex mx;
+	condition_variable cv;
+	uint32_t hashed= 0;		// batches hashed
+	uint32_t probed= 0;		// batches probed
+	uint64_t hits= 0;
+	Time start_time= start_timer();
+	mt19937 source_rand(mt_rand());
+	thread hasher([&](){
+		SetThreadAffinityMask(GetCurrentThread(), hash_mask);
+		for (uint32_t b= 0; b < batch_count; b++) {
+			// the container is free when its batch of 3 stages ago has been probed
+			{unique_lock<mutex> lk(mx); cv.wait(lk, [&]{return b < probed + 3;});}
+			container &c= ctr[b % 3];
+			// fresh bytes for every batch (cost of worker1, same affinity mask): the probes miss the cache as in gather
+			for (uint32_t j= 0; j < batch_size + L; j+= 4) {
+				uint32_t r= source_rand();
+				memcpy(c.buf.data() + j, &r, 4);
+			}
+			hash_batch(c.buf.data(), batch_size, c.com.data(), c.div);
+			{lock_guard<mutex> lk(mx); hashed++;} cv.notify_all();
+		}
+	});
+	thread prober([&](){
+		SetThreadAffinityMask(GetCurrentThread(), probe_mask);
+		for (uint32_t b= 0; b < batch_count; b++) {
+			{unique_lock<mutex> lk(mx); cv.wait(lk, [&]{return b < hashed;});}
+			container &c= ctr[b % 3];
+			hits+= probe_batch(c.com.data(), c.div, batch_size, distance);
+			{lock_guard<mutex> lk(mx); probed++;} cv.notify_all();
+		}
+	});
+	hasher.join();
+	prober.join();
+	double elapsed= get_elapsed_time(start_time);
+	for (uint32_t c= 0; c < 3; c++) delete[] ctr[c].div;
+	if (hits > batch_count * batch_size) exit(12);
+	return(elapsed * 1e6 / ((double)batch_count * batch_size));
+}
+
+int
+main()
+{
+	time_t  cur_time = time(NULL);
+	mt19937 mt_rand(time(&cur_time));
+	uint32_t cpu_count= thread::hardware_concurrency();
+	if (cpu_count == 0) cpu_count= 1;
+	m_com= CAL_MAP_SIZE - M_DIV;
+
+	printf("\n");
+	printf("autotune_v1 \n");
+	printf("=========== \n");
+	printf("calibration map       : %llu [bytes] \t(occupancy %.2f) \n", CAL_MAP_SIZE, CAL_OCCUPANCY);
+	printf("shingles per pass     : %llu \n", CAL_SHINGLES);
+	printf("logical processors    : %u \n", cpu_count);
+	printf("\n");
+	fflush(stdout);
+
+	// random probes: huge pages and prefetch distance
+	// -----------------------------------------------
+	// CAL_SHINGLES distinct random hashes in chunks of 64K: a pass touches about 2 * CAL_SHINGLES map lines
+	// (far more than the LLC), each probe is a DRAM access as in gather
+	vector<uint32_t> com(CAL_SHINGLES);
+	uint8_t (*div)[64*1024]= new uint8_t[CAL_SHINGLES / (64*1024) * DV][64*1024];
+	for (uint64_t k= 0; k < CAL_SHINGLES; k+= 64*1024) {
+		for (uint32_t j= 0; j < 64*1024; j++) {
+			com[k + j]= mt_rand() % m_com;
+			for (uint8_t id= 0; id < DV; id++) div[k / (64*1024) * DV + id][j]= mt_rand() % M_DIV;
+		}
+	}
+	auto probe_pass= [&](uint32_t distance){
+		// [nanoseconds per shingle]
+		Time start_time= start_timer();
+		uint64_t hits= 0;
+		for (uint64_t k= 0; k < CAL_SHINGLES; k+= 64*1024) {
+			hits+= probe_batch(com.data() + k, div + k / (64*1024) * DV, 64*1024, distance);
+		}
+		if (hits > CAL_SHINGLES) exit(12);
+		return(get_elapsed_time(start_time) * 1e6 / CAL_SHINGLES);
+	};
+	bool best_huge= false;
+	double best_probe= 0;
+	for (int huge= 0; huge <= 1; huge++) {
+#ifndef __linux__
+		if (huge) break;
+#endif
+		map= alloc_map(m_com + M_DIV, huge); if (map == NULL) exit(11);
+		fill_map(mt_rand);
+		double t= probe_pass(0);
+		printf("huge pages %d         : %7.2f [nanoseconds per shingle] \n", huge, t);
+		if (huge == 0 || t < best_probe) {
+			best_probe= t;
+			best_huge= huge;
+		}
+		free(map);
+	}
+	map= alloc_map(m_com + M_DIV, best_huge); if (map == NULL) exit(11);
+	fill_map(mt_rand);
+	uint32_t best_distance= 0;
+	for (uint32_t distance : prefetch_distances) {
+		double t= probe_pass(distance);
+		printf("prefetch distance %2u : %7.2f [nanoseconds per shingle] \n", distance, t);
+		if (distance == 0 || t < best_probe) {
+			best_probe= t;
+			best_distance= distance;
+		}
+	}
+	delete[] div;
+
+	// pipeline: batch size and thread layout
+	// --------------------------------------
+	// layouts (hash thread, probe thread): not pinned, the probe thread on a processor of its own
+	vector<pair<uint64_t, uint64_t>> layouts;
+	uint64_t all= (cpu_count >= 64) ? ~0ULL : (1ULL << cpu_count) - 1;
+	layouts.push_back({all, all});
+	if (cpu_count >= 2) {
+		uint64_t last= 1ULL << (min(cpu_count, 64U) - 1);
+		layouts.push_back({all & ~last, last});
+		layouts.push_back({1ULL, 2ULL});
+	}
+	uint32_t best_batch_size= 8*1024;
+	pair<uint64_t, uint64_t> best_layout= layouts[0];
+	double best_pipeline= 0;
+	printf("\n");
+	printf("batch size   hash mask  probe mask   [nanoseconds per shingle] \n");
+	for (const pair<uint64_t, uint64_t> &layout : layouts) {
+		for (uint32_t batch_size : batch_sizes) {
+			double t= pipeline_pass(batch_size, best_distance, layout.first, layout.second, mt_rand);
+			printf("%10u %11llx %11llx   %7.2f \n", batch_size, layout.first, layout.second, t);
+			fflush(stdout);
+			if (best_pipeline == 0 || t < best_pipeline) {
+				best_pipeline= t;
+				best_batch_size= batch_size;
+				best_layout= layout;
+			}
+		}
+	}
+	free(map);
+
+	// profile
+	// -------
+	printf("\n");
+	printf("profile \n");
+	printf("------- \n");
+	printf("BATCH_SIZE            : %u \n", best_batch_size);
+	printf("PREFETCH_DISTANCE     : %u \n", best_distance);
+	printf("HUGEPAGES             : %d \n", best_huge);
+	printf("AFFINITY_PIPELINE     : 0x%llx \t(worker1, worker2) \n", best_layout.first);
+	printf("AFFINITY_PROBE        : 0x%llx \t(worker3) \n", best_layout.second);
+	ofstream profile_stream(profile_file_name);
+	if (!profile_stream) {
+		cerr << "Can't open profile file!";
+		exit(13);
+	}
+	profile_stream << "// " << profile_file_name << ": written by autotune (" << best_pipeline << " nanoseconds per shingle)\n";
+	profile_stream << "#define BATCH_SIZE  " << best_batch_size << "\n";
+	profile_stream << "#define PREFETCH_DISTANCE  " << best_distance << "\n";
+	profile_stream << "#define HUGEPAGES  " << best_huge << "\n";
+	profile_stream << "#define AFFINITY_PIPELINE  0x" << hex << best_layout.first << "ULL\n";
+	profile_stream << "#define AFFINITY_PROBE     0x" << best_layout.second << "ULL\n";
+	profile_stream.close();
+	printf("profile file          : %s \n", profile_file_name.c_str());
+	printf("\n");
+	printf("end \n");
+}
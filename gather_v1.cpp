@@ -24,6 +24,9 @@
 //
 // Compilation flags:
 // -O3 -g3 -Wall         : optimization
+// -mavx2 (-march=native): SIMD hashing and probe kernels (scalar fallback otherwise)
+// -mavx512f              : 16 shingle probe kernel
+// -msse4.2               : hardware CRC32C fingerprints (table fallback otherwise)
 // -Wl,--stack,0xFFFFFF  : long arrays
 // if required: upgrade minGW to x86_64 : 64 bit executable
 //
@@ -38,8 +41,21 @@
 // ================================================================================
 
 #include <iostream>
+#include <iomanip>
 #include <fstream>
 #include <random>
+#include <array>
+#include <vector>
+#include <cstring>
+#include <atomic>
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#endif
 #include "mingw.thread.h"
 #include "mingw.mutex.h"
 #include "mingw.condition_variable.h"
@@ -57,35 +73,207 @@ double get_elapsed_time(Time start) {
 }
 // random cyclic permutations
 void rcp_generator(std::mt19937& mt_rand, uint8_t p[]);
-time_t load_hash_map(string map_file_name);
+time_t load_hash_map(string map_file_name, uint32_t round);
 
 // file names
 // ----------
 // input: read S from master file
 const string master_string_file_name= "C:\\cr\\master.txt";
+// input (STREAMING): unbounded test data S, e.g. a named pipe ("-": standard input)
+const string stream_file_name= "C:\\cr\\stream.fifo";
+#define STREAMING  0		// 1: streaming mode, S is read from the stream until end-of-stream (instead of the master file)
+#define MAX_LATENCY_MS  10	// streaming: a batch is flushed at the latest MAX_LATENCY_MS after the arrival of its first byte
+							// (its verdict follows two stages later, each lasting at most MAX_LATENCY_MS + processing time)
 // input: read hash map
 const string map_file_name_prefix=    "C:\\cr\\v1_map_";
+// input (COUNTING_MAP): read the counting map of scatter instead of the exported bitmap
+const string counting_map_file_name_prefix= "C:\\cr\\v1_cmap_";
+#define COUNTING_MAP  0
+// input (GENERATIONS > 0): sliding reference window, the last GENERATIONS generation maps of scatter ("_g<g>")
+// are combined into one map (AND of the bitmaps: union of the reference sets), a background thread
+// refreshes the combined map when a new generation appears
+#define GENERATIONS  0
+#define MAX_GENERATION  4096	// highest generation searched
+#define REFRESH_MS  1000		// polling interval of the refresh thread [milliseconds]
+// output: reduced problem, surviving regions ("S": test string, "s": reference string) and their index
+const string reduced_file_name_prefix= "C:\\cr\\v1_reduced_";
+#define WRITE_REDUCED  1	// 1: write the reduced problem
+#define COPY_SIZE  (1ULL << 20)	// buffer size of the buffered copy
+// out-of-core gather (OUT_OF_CORE 1): the map is never held in RAM as a whole, S is processed in slabs,
+// the probes of a slab are spilled partitioned by map region and resolved while the map is streamed region by region
+const string spill_file_name_prefix= "C:\\cr\\v1_spill_";
+#define OUT_OF_CORE  0
+#define REGIONS  16					// map regions (map memory: M_COM / REGIONS + M_DIV bytes)
+#define SLAB_SIZE  (64ULL << 20)	// shingles per slab (hit mask: SLAB_SIZE / 8 bytes, spill: 16 bytes per shingle)
+#define SPILL_BUFFER  (64*1024)		// spill records buffered per region
+// live progress (PROGRESS_MS > 0): a reporter thread samples the stage counters every PROGRESS_MS and prints
+// throughput, residue rate and ETA, optionally also to the metrics file (one line per sample, ";" separated)
+const string metrics_file_name= "C:\\cr\\v1_metrics_gather.txt";
+#define PROGRESS_MS  5000	// reporter interval [milliseconds] (0: no reporter)
+#define METRICS_FILE  0		// 1: write the samples to the metrics file
+// pipeline trace (TRACE 1): begin/end of every wait and process step of the workers per container (A,B,C)
+// and of the scheduler signals, recorded in per-thread ring buffers and written as Chrome trace JSON
+// (chrome://tracing, ui.perfetto.dev) after the run
+const string trace_file_name= "C:\\cr\\v1_trace_gather.json";
+#define TRACE  0
+#define TRACE_EVENTS  (1 << 16)	// ring buffer per thread: the latest TRACE_EVENTS events are kept
+// stage-isolated benchmarking: pipeline endpoints (the map is loaded in any case)
+#define SOURCE_MASTER     0	// worker1 reads S from the master file (or the stream)
+#define SOURCE_SYNTHETIC  1	// worker1 generates NS IID bytes in memory (no disk read)
+#define SOURCE  SOURCE_MASTER
+#define SYNTHETIC_SEED  0x2545F4914F6CDD1DULL	// fixed seed: the same bytes in each run
+#define SINK_PROBE     0	// worker3 probes the map (filtration)
+#define SINK_NULL      1	// worker3 discards the hashes
+#define SINK_CHECKSUM  2	// worker3 folds the hashes into a checksum (no map access)
+#define SINK  SINK_PROBE
+#define HASH_STAGE  1		// 0: worker2 passes the batches on unhashed (SINK_NULL: worker1 alone)
+const char *source_name[]= {"master file", "synthetic IID bytes"};
+// probe-result cache (PROBE_CACHE 1): verdicts of the latest fingerprints (Bloom, xor, counting map: scalar probes
+// of all shingles), direct-mapped, L1 resident. Low-entropy regions (constant, periodic) repeat their fingerprints
+// and skip the key hashing and map reads. A batch with a hit rate below PROBE_CACHE_MIN_RATE doubles the bypass
+// (batches probed without the cache). The bitmap is not cached: its vectorized probe of repeated (cache resident)
+// slots is faster than the lookup
+#define PROBE_CACHE  1
+#define PROBE_CACHE_BITS  10			// 2^10 slots of 16 bytes: 16 KB
+#define PROBE_CACHE_MIN_RATE  0.25
+#define PROBE_CACHE_MAX_BYPASS  256		// batches
+// dedup cache (DEDUP 1): persistent cache of already filtered test chunks (batches) keyed by (map id, chunk hash).
+// The chunk hash covers the carry and the batch (all bytes of its shingles), a cached chunk skips hashing and probing:
+// its hit runs are replayed into the run detection, which joins the runs across the chunk boundaries
+const string dedup_file_name_prefix= "C:\\cr\\v1_dedup_";
+#define DEDUP  0
+#define DEDUP_MAX_ENTRIES  (1ULL << 24)	// chunks kept in the cache file
+#define DEDUP_MAGIC  0x31504444U		// "DDP1"
+// content-defined chunk matching (CDC 1): scatter records the content-defined chunks of s (gear hash boundaries)
+// in the chunk file, worker1 chunks S the same way and looks its chunks up. A chunk found in s is emitted as a
+// confirmed common substring (test offset, reference offset, length), worker3 skips the shingles inside it:
+// the per-shingle filter runs on the remaining bytes and on the shingles crossing the chunk boundaries
+const string chunk_file_name_prefix= "C:\\cr\\v1_chunks_";
+#define CDC  0
+#define CDC_MIN_SIZE  1024		// chunk length [bytes] (same values in scatter and gather: chunk file header)
+#define CDC_MAX_SIZE  8192		// <= BATCH_SIZE: a chunk is decided before worker3 checks its first batch
+#define CDC_BITS  12			// boundary: the top CDC_BITS of the gear hash are zero (mean chunk ~ CDC_MIN_SIZE + 4 KB)
+#define CDC_MAGIC  0x31434443U	// "CDC1"
+#define CDC_RING  1024			// matches in flight from worker1 to worker3
+// existence mode (EXISTENCE 1): yes/no, does S share a substring of length >= LP with s? The survivor runs (and the
+// confirmed chunks, CDC) are candidates, worker3 verifies a run by all its windows of LP bytes against s (EXISTENCE_VERIFY:
+// one scan of s in the master file per candidate, a run verified while open gets a second one for its new windows when
+// it closes). A confirmed match cancels reading, hashing and probing in all threads, the latency
+// is proportional to the distance of the first match in S. Without a re-readable S (stream, synthetic source) or s
+// (generations) the first run is the answer (unverified: a false positive with the probability of the residue)
+#define EXISTENCE  0
+#define EXISTENCE_VERIFY  1
+const char *sink_name[]= {"map probe", "null", "checksum"};
+// machine profile: autotune.cpp writes v1_profile.h (batch size, prefetch distance, huge pages, affinity masks),
+// it overrides the defaults below
+#if __has_include("v1_profile.h")
+#include "v1_profile.h"
+#endif
 // batch size of input buffers and hash values (cf. CONTAINERS)
+#ifndef BATCH_SIZE
 #define BATCH_SIZE   (8*1024)
+#endif
+#ifndef PREFETCH_DISTANCE
+#define PREFETCH_DISTANCE  0		// map prefetch: shingles ahead of the current one (0: none)
+#endif
+#ifndef HUGEPAGES
+#define HUGEPAGES  0				// 1: map on transparent huge pages (madvise, linux)
+#endif
+#ifndef AFFINITY_PIPELINE
+#define AFFINITY_PIPELINE  7ULL		// affinity mask of worker1 and worker2
+#define AFFINITY_PROBE     8ULL		// affinity mask of worker3 (map access)
+#endif
+// map allocation (after the machine profile: HUGEPAGES): on transparent huge pages (linux) the random map
+// accesses cause fewer TLB misses
+#if HUGEPAGES && defined(__linux__)
+#include <sys/mman.h>
+#endif
+uint8_t *alloc_map(uint64_t size) {
+#if HUGEPAGES && defined(__linux__)
+	const uint64_t huge_page= 1ULL << 21;
+	uint64_t length= (size + huge_page - 1) / huge_page * huge_page;
+	uint8_t *p= (uint8_t *)aligned_alloc(huge_page, length);
+	if (p != NULL) madvise(p, length, MADV_HUGEPAGE);
+	return(p);
+#else
+	return((uint8_t *)malloc(size));
+#endif
+}
 
 // GLOBAL PARAMETERS: same values in scatter and gather!
 // =================
 
+// shingling engines (recorded in the map header)
+#define ENGINE_DIVERSIFIED  0	// L-shingles: a common substring of length LP is a run of LP-L+1 hits
+#define ENGINE_PREFIX       1	// prefix shingling: LP-shingles, a common substring of length LP is a single hit
+#define ENGINE  ENGINE_DIVERSIFIED	// same engine in scatter and gather (map header)
+const char *engine_name[]= {"diversified L-shingles", "prefix shingling"};
 #define DV   8		// number of diversified hashes == 8 for this implementation (byte packed!!)
-#define L    5		// shingle length L
-#define LC  (L-1)	// shingle carry length : LC == L - 1
+// planner configuration: planner.cpp writes v1_config.h (ns, NS, M_COM, L_SHINGLE, LP), it overrides the defaults below
+#if __has_include("v1_config.h")
+#include "v1_config.h"
+#endif
+#ifndef LP
 #define LP  10		// prefix length (>= L)
+#endif
+#ifndef L_SHINGLE
+#define L_SHINGLE  5	// shingle length of the diversified engine
+#endif
+#define L    ((ENGINE == ENGINE_PREFIX) ? LP : L_SHINGLE)		// shingle length L
+#define LC  (L-1)	// shingle carry length : LC == L - 1
+#ifndef ns
 #define ns      1000000000ULL 		// length of the reference string s [bytes]
+#endif
+#ifndef NS
 #define NS       100000000ULL		// length of the test string S (NS bytes)
+#endif
 #define N       (NS - L + 1)		// number of test shingles
+#ifndef M_COM
 #define M_COM   1000000007ULL		// modulus of the common hashes
+#endif
 #define B_COM   257ULL				// base of the common hashes (first prime > 256)
 #define M_DIV   67ULL
+// common hashes: 32 bit, 64 bit for maps of 2^31 bytes and more (no 32 bit vector gathers)
+#define WIDE_MAP  (M_COM + M_DIV >= (1ULL << 31))
+#if WIDE_MAP
+typedef uint64_t com_t;
+#else
+typedef uint32_t com_t;
+#endif
 
 // scatter_v1: diversified fingerprint bases
 // -----------------------------------------
-// 1 cache-line	 ( 64 bytes)
-const uint64_t B_DIV[DV]= {257, 263, 269, 271, 277, 281, 283, 293};
+// 1 cache-line	 ( 64 bytes) per filtering round:
+// round k > 1 re-filters the survivors of round k-1 with a fresh base set (and seed)
+#define MAX_ROUNDS  4
+const uint64_t B_DIV_SET[MAX_ROUNDS][DV]= {
+		{257, 263, 269, 271, 277, 281, 283, 293},
+		{307, 311, 313, 317, 331, 337, 347, 349},
+		{353, 359, 367, 373, 379, 383, 389, 397},
+		{401, 409, 419, 421, 431, 433, 439, 443}};
+#define TWO_SIDED  0	// 1: reduce the reference string s as well (against a map of the survivors of S)
+#define RED_FACTOR  64	// slots per cofilter of the reduced map per surviving test shingle
+#define ROUNDS  1	// filtering rounds (1..MAX_ROUNDS): round k > 1 re-filters the survivors against map "_r<k>"
+static_assert(ROUNDS >= 1 && ROUNDS <= MAX_ROUNDS, "1 <= ROUNDS <= MAX_ROUNDS");
+static_assert(!STREAMING || (ROUNDS == 1 && !TWO_SIDED && !WRITE_REDUCED), "streaming: the survivors are not re-read (ROUNDS 1, TWO_SIDED 0, WRITE_REDUCED 0)");
+static_assert(!OUT_OF_CORE || (!STREAMING && GENERATIONS == 0 && ROUNDS == 1 && !TWO_SIDED && !COUNTING_MAP),
+		"out-of-core gather: bitmap of a single map (STREAMING 0, GENERATIONS 0, ROUNDS 1, TWO_SIDED 0, COUNTING_MAP 0)");
+static_assert((SOURCE == SOURCE_MASTER && SINK == SINK_PROBE) || (!OUT_OF_CORE && ROUNDS == 1 && !TWO_SIDED && !WRITE_REDUCED),
+		"benchmark endpoints: the survivors are not re-read (OUT_OF_CORE 0, ROUNDS 1, TWO_SIDED 0, WRITE_REDUCED 0)");
+static_assert(SOURCE == SOURCE_MASTER || !STREAMING, "synthetic source: STREAMING 0");
+static_assert(HASH_STAGE || SINK == SINK_NULL, "unhashed batches: SINK_NULL");
+static_assert(!DEDUP || (SINK == SINK_PROBE && GENERATIONS == 0 && !OUT_OF_CORE),
+		"dedup cache: verdicts of a fixed map in memory (SINK_PROBE, GENERATIONS 0, OUT_OF_CORE 0)");
+static_assert(!CDC || (SINK == SINK_PROBE && !STREAMING && !OUT_OF_CORE && GENERATIONS == 0 && !DEDUP),
+		"chunk matching: pipeline of a fixed map (SINK_PROBE, STREAMING 0, OUT_OF_CORE 0, GENERATIONS 0, DEDUP 0)");
+static_assert(!EXISTENCE || (SINK == SINK_PROBE && !OUT_OF_CORE && ROUNDS == 1 && !TWO_SIDED),
+		"existence mode: single pass of the pipeline (SINK_PROBE, OUT_OF_CORE 0, ROUNDS 1, TWO_SIDED 0)");
+static_assert(!CDC || (CDC_MIN_SIZE >= 64 && CDC_MIN_SIZE >= LP && CDC_MAX_SIZE <= BATCH_SIZE && CDC_RING >= 3 * BATCH_SIZE / CDC_MIN_SIZE + 2),
+		"chunk matching: 64, LP <= CDC_MIN_SIZE, CDC_MAX_SIZE <= BATCH_SIZE, CDC_RING covers three batches");
+#if STREAMING && !defined(__linux__)
+#error "streaming mode: poll() based reader (linux)"
+#endif
+const uint64_t (&B_DIV)[DV]= B_DIV_SET[0];
 
 // C_COM= (B_COM ^ L) % M_COM
 auto c_com= [](){
@@ -110,6 +298,182 @@ auto c_div= [](int id){
 const uint64_t C_DIV[DV]= {c_div(0), c_div(1), c_div(2), c_div(3),
 						   c_div(4), c_div(5), c_div(6), c_div(7)};
 
+// P_COM[k]= (B_COM ^ (L-1-k)) % M_COM	: coefficients of the position-parallel common hashes
+auto p_com= [](){
+		array<uint64_t, L> result;
+		result[L-1]= 1ULL;
+		for (int k = L-2; k >= 0; k--) {
+			result[k]= (result[k+1] * B_COM) % M_COM;
+		}
+		return result;
+};
+const array<uint64_t, L> P_COM= p_com();
+
+// P_DIV[id][k]= (B_DIV[id] ^ (L-1-k)) % M_DIV	: coefficients of the position-parallel diversified hashes
+auto p_div= [](const uint64_t b_div[DV]){
+		array<array<uint64_t, L>, DV> result;
+		for (int id = 0; id < DV; id++) {
+			result[id][L-1]= 1ULL;
+			for (int k = L-2; k >= 0; k--) {
+				result[id][k]= (result[id][k+1] * b_div[id]) % M_DIV;
+			}
+		}
+		return result;
+};
+array<array<uint64_t, L>, DV> P_DIV= p_div(B_DIV);	// current round
+
+// fingerprint families (recorded in the map header)
+// -------------------
+#define FP_RABIN_KARP  0	// Rabin-Karp: polynomial hashes (B_COM, M_COM) and (B_DIV[], M_DIV)
+#define FP_CRC32C      1	// CRC32C of the L-byte window, reduced by multiply-shift
+const char *fp_family_name[]= {"Rabin-Karp", "CRC32C"};
+
+// CRC32C: the window word w is hashed twice, c0= crc(w) and c1= crc(w * CRC_MIX),
+// the premix makes c1 independent of c0 (CRCs with different seeds only differ by a constant)
+#define CRC_SEED  0xFFFFFFFFU
+#define CRC_MIX   0x9E3779B97F4A7C15ULL
+// CRC32C: multiply-shift factors of the diversified hashes (odd)
+const uint32_t A_DIV[DV]= {0x6659FD93, 0x78BD642F, 0xA0B428DB, 0x9C88C6E3, 0x75374CC3, 0xC47D124F, 0x1CE4E5B9, 0x133111EB};
+// CRC32C (Castagnoli, reflected polynomial 0x82F63B78): table of the software fallback
+auto crc_table= [](){
+		array<uint32_t, 256> result;
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) c = (c & 1) ? (c >> 1) ^ 0x82F63B78U : c >> 1;
+			result[i]= c;
+		}
+		return result;
+};
+const array<uint32_t, 256> CRC_TABLE= crc_table();
+
+// content-defined chunking: gear hash g= (g << 1) + GEAR_TABLE[byte], its top bits depend on the last 64 bytes
+auto gear_table= [](){
+		array<uint64_t, 256> result;
+		uint64_t x= 0;
+		for (uint32_t i = 0; i < 256; i++) {
+			uint64_t z= (x+= 0x9E3779B97F4A7C15ULL);
+			z= (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z= (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			result[i]= z ^ (z >> 31);
+		}
+		return result;
+};
+const array<uint64_t, 256> GEAR_TABLE= gear_table();
+
+// shingle sampling (recorded in the map header)
+// ----------------
+// SAMPLE_MINIMIZER: of every window of LT= LP-L+1 consecutive shingles (a substring of length LP)
+// only the minimizer is inserted (scatter) and probed (gather). A common substring of length
+// >= LP has the same minimizer in s and S, thus no common substring is lost, while map fill
+// and probe volume drop to the minimizer density ~ 2 / (LT+1).
+#define SAMPLE_ALL        0	// every shingle
+#define SAMPLE_MINIMIZER  1	// window minimizers
+const char *sampling_name[]= {"all shingles", "window minimizers"};
+#define LT  (LP - L + 1)	// window [shingles] (run threshold)
+// minimizer order: mixed common hash (the plain minimum would crowd the low map addresses)
+#define MINIMIZER_KEY(com)  ((uint32_t)((com) * 0x9E3779B1U))
+// sliding window of the last LT shingles (carried across batches)
+struct minimizer_window {
+	uint64_t position[LT];		// shingle offset
+	uint32_t key[LT];			// MINIMIZER_KEY of the common hash
+	com_t    com[LT];			// common hash
+	uint8_t  div[LT][DV];		// diversified hashes
+	uint64_t seen= 0;			// number of shingles pushed
+	uint64_t last= ~0ULL;		// offset of the last minimizer
+};
+// push a shingle, returns true when the window is complete; m: ring index of the minimizer
+inline bool push_window(minimizer_window &mw, uint64_t position, com_t com, const uint8_t div_hash[][BATCH_SIZE], uint32_t j, uint32_t &m) {
+	uint32_t r= mw.seen % LT;
+	mw.position[r]= position;
+	mw.key[r]= MINIMIZER_KEY(com);
+	mw.com[r]= com;
+	for (uint8_t id= 0; id < DV; id++) mw.div[r][id]= div_hash[id][j];
+	if (++mw.seen < LT) return(false);
+	// leftmost minimum, scanning from the oldest shingle
+	m= mw.seen % LT;
+	for (uint32_t k= 1; k < LT; k++) {
+		uint32_t q= (mw.seen + k) % LT;
+		if (mw.key[q] < mw.key[m]) m= q;
+	}
+	return(true);
+}
+
+// map file header
+// ---------------
+#define MAP_MAGIC  0x31465343U	// "CSF1"
+struct map_header {
+	time_t   setup_time;		// map setup time (seed of the cyclic permutations)
+	uint32_t magic;				// MAP_MAGIC
+	uint32_t fp_family;			// fingerprint family (FP_RABIN_KARP, FP_CRC32C)
+	uint64_t m_com;				// modulus of the common hashes
+	uint64_t m_div;				// modulus of the diversified hashes
+	uint32_t sampling;			// shingle sampling (SAMPLE_ALL, SAMPLE_MINIMIZER)
+	uint32_t window;			// minimizer window [shingles]
+	uint32_t round;				// filtering round (diversified base set B_DIV_SET[round-1])
+	uint32_t engine;			// shingling engine (ENGINE_DIVERSIFIED, ENGINE_PREFIX)
+	uint32_t backend;			// filter backend (BACKEND_BITMAP, BACKEND_BLOOM, BACKEND_XOR)
+	uint32_t bloom_k;			// bits per key of the blocked Bloom filter
+	uint64_t map_size;			// length of the map following the header [bytes]
+	uint64_t filter_seed;		// hash seed of the xor filter
+	uint32_t generation;		// generation of a sliding reference window (0: single map)
+	uint64_t fold;				// folded (sparse) bitmap: modulus of the common hashes (0: not folded)
+};
+
+// filter backends (recorded in the map header)
+// ---------------
+// scatter builds and gather queries the set of the reference shingle fingerprints (com, div[DV]):
+// BACKEND_BITMAP: DV cofilters of 1 bit per slot (com + div[id]), DV map reads per query
+// BACKEND_BLOOM : register-blocked Bloom filter, BLOOM_K bits in one 64 bit block, 1 map read per query
+// BACKEND_XOR   : static xor filter of 8 bit fingerprints, 3 map reads per query
+//                 (built at the end of scatter from the complete key set: ~ 40 bytes per key while building)
+// BACKEND_COUNTING: counting map, the DV cofilters of a slot packed as 4 bit counters in one uint32,
+//                 reference ranges can be added and removed, compacted to the bitmap (DV map reads per query)
+#define BACKEND_BITMAP    0
+#define BACKEND_BLOOM     1
+#define BACKEND_XOR       2
+#define BACKEND_COUNTING  3
+const char *backend_name[]= {"bitmap (DV cofilters)", "blocked Bloom filter", "xor filter", "counting map"};
+const uint32_t backend_reads[]= {DV, 1, 3, DV};	// map reads per query
+#define COUNTER_MAX  15		// saturated 4 bit counter (sticky: never decremented)
+#define BLOOM_K  6			// bits per key of the blocked Bloom filter
+
+// 64 bit key of the shingle fingerprint (com, div[DV])
+inline uint64_t shingle_key(com_t com, const uint8_t d[DV]) {
+	uint64_t w;
+	memcpy(&w, d, 8);		// DV == 8 diversified hashes
+	uint64_t x= ((uint64_t)com << 32 | (uint64_t)com >> 32) ^ (w * 0x9E3779B97F4A7C15ULL);
+	// murmur3 finalizer
+	x^= x >> 33; x*= 0xFF51AFD7ED558CCDULL;
+	x^= x >> 33; x*= 0xC4CEB9FE1A85EC53ULL;
+	x^= x >> 33;
+	return(x);
+}
+// blocked Bloom filter: block of the key (blocks < 2^32) and its BLOOM_K bits
+inline uint64_t bloom_block(uint64_t key, uint64_t blocks) {
+	return(((key >> 32) * blocks) >> 32);
+}
+inline uint64_t bloom_mask(uint64_t key) {
+	uint64_t y= key * 0x9E3779B97F4A7C15ULL;
+	uint64_t mask= 0;
+	for (uint32_t i= 0; i < BLOOM_K; i++) mask|= 1ULL << ((y >> (58 - 6*i)) & 63);
+	return(mask);
+}
+// xor filter: hash of the key, its slot in segment i (of 3) and its fingerprint
+inline uint64_t xor_hash(uint64_t key, uint64_t seed) {
+	uint64_t x= key + seed;
+	x^= x >> 33; x*= 0xFF51AFD7ED558CCDULL;
+	x^= x >> 33; x*= 0xC4CEB9FE1A85EC53ULL;
+	x^= x >> 33;
+	return(x);
+}
+inline uint64_t xor_slot(uint64_t h, uint32_t i, uint64_t segment) {
+	uint64_t r= (i == 0) ? h : (h << (21*i)) | (h >> (64 - 21*i));
+	return(i * segment + (((r & 0xFFFFFFFFULL) * segment) >> 32));
+}
+inline uint8_t xor_fingerprint(uint64_t h) {
+	return((uint8_t)(h ^ (h >> 32)));
+}
+
 
 // THREADS (1,2,3) working on three containers (A,B,C)
 // =======
@@ -125,7 +489,7 @@ double worker1_waiting_time;
 // WORKER 2 : produce hash
 void worker2_thread();
 // hash the shingles of the batch
-void hash_batch(uint8_t s[], uint32_t hash_count, uint64_t com_hash[], uint8_t div_hash[]);
+void hash_batch(uint8_t s[], uint32_t hash_count, com_t com_hash[], uint8_t div_hash[][BATCH_SIZE]);
 mutex mx2;
 condition_variable cv2;
 bool cv2_scheduler_enabled= false;
@@ -135,7 +499,10 @@ double worker2_waiting_time;
 // WORKER 3 : consume hash
 void worker3_thread();
 // check the hash values of the batch against the map
-void check_batch(uint32_t hash_count, uint64_t com_hash[], uint8_t div_hash[]);
+void check_batch(uint32_t j0, uint32_t hash_count, com_t com_hash[], uint8_t div_hash[][BATCH_SIZE]);
+// pass the hash values of the batch to the sink (SINK_PROBE: check_batch)
+void sink_batch(uint32_t j0, uint32_t hash_count, com_t com_hash[], uint8_t div_hash[][BATCH_SIZE]);
+uint64_t sink_checksum= 0;		// SINK_CHECKSUM: FNV-1a of the hashes in shingle order
 mutex mx3;
 condition_variable cv3;
 bool cv3_scheduler_enabled= false;
@@ -143,30 +510,261 @@ bool cv3_worker3_enabled= false;
 double worker3_process_time;
 double worker3_waiting_time;
 
+// PROGRESS COUNTERS
+// =================
+// written once per batch by their worker (single writer: relaxed load + store, no locked instruction),
+// read by the reporter thread (relaxed: no synchronization with the hot loops)
+alignas(64) atomic<uint64_t> progress_bytes(0);		// worker1: bytes read
+alignas(64) atomic<uint64_t> progress_hashed(0);	// worker2: shingles hashed
+alignas(64) atomic<uint64_t> progress_probes(0);	// worker3: probed shingles
+atomic<uint64_t> progress_residue(0);				// worker3: current residue
+atomic<bool> progress_stop(false);
+inline void progress_add(atomic<uint64_t> &counter, uint64_t x) {
+	counter.store(counter.load(memory_order_relaxed) + x, memory_order_relaxed);
+}
+void progress_thread(uint64_t total_bytes);
+
+// TRACE RING BUFFERS
+// ==================
+// one ring per thread (0: scheduler, 1..3: worker1..3), written by its thread only, read after the join
+#define TRACE_SIGNAL   0	// scheduler: start-signals sent to the workers
+#define TRACE_STAGE    1	// scheduler: waiting for the end-signals of the stage
+#define TRACE_WAIT     2	// worker: waiting for the start-signal
+#define TRACE_PROCESS  3	// worker: processing a container
+const char *trace_kind_name[]= {"signal", "stage", "wait", "process"};
+struct trace_event {
+	double begin;			// [microseconds] since trace_epoch
+	float duration;			// [microseconds]
+	uint32_t id;			// batch_id (worker), stage_id (scheduler)
+	uint8_t kind;
+	char container;			// 'A', 'B', 'C' (scheduler: ' ')
+};
+struct trace_ring {
+	trace_event events[TRACE ? TRACE_EVENTS : 1];
+	uint64_t count;			// events recorded
+};
+trace_ring trace_rings[4];
+Time trace_epoch;
+inline void trace(uint32_t tid, uint8_t kind, char container, uint32_t id, Time begin) {
+	if (!TRACE) return;
+	Time end= start_timer();
+	trace_ring &ring= trace_rings[tid];
+	trace_event &e= ring.events[ring.count++ % TRACE_EVENTS];
+	e.begin= chrono::duration<double, micro>(begin - trace_epoch).count();
+	e.duration= chrono::duration<float, micro>(end - begin).count();
+	e.id= id;
+	e.kind= kind;
+	e.container= container;
+}
+uint64_t write_trace();
+
 // CONTAINERS (A,B,C)
 // ==================
+// hash batches are aligned structures of arrays: 32 bit common hashes and
+// DV lanes of diversified hashes, streamed lane by lane by producer and consumer
 // CONTAINER A
 bool ctr_A_busy= false;					// true: container A busy (a worker is processing its contents)
 uint8_t  buf_ctr_A[BATCH_SIZE + LC];	// string buffer: length= buffer size + carry length
-uint64_t com_ctr_A[BATCH_SIZE];			// hash buffer  : common hashes
-uint8_t  div_ctr_A[BATCH_SIZE * DV];	// hash buffer  : diversified hashes (DV number of cofilters)
+alignas(64) com_t    com_ctr_A[BATCH_SIZE];		// hash buffer  : common hashes (com_t)
+alignas(64) uint8_t  div_ctr_A[DV][BATCH_SIZE];	// hash buffer  : diversified hashes (one lane per cofilter)
+uint32_t size_ctr_A;					// streaming: batch size (variable)
+int64_t  dedup_ctr_A;					// dedup cache: entry of the chunk (-1: not cached, -2: not looked up)
+uint64_t dedup_key_ctr_A;				// dedup cache: chunk hash
+Time     arrival_ctr_A;					// streaming: arrival time of the first byte of the batch
 // CONTAINER B
 bool ctr_B_busy= false;					// true: container B busy
 uint8_t  buf_ctr_B[BATCH_SIZE + LC];
-uint64_t com_ctr_B[BATCH_SIZE];
-uint8_t  div_ctr_B[BATCH_SIZE * DV];
+alignas(64) com_t    com_ctr_B[BATCH_SIZE];
+alignas(64) uint8_t  div_ctr_B[DV][BATCH_SIZE];
+uint32_t size_ctr_B;
+int64_t  dedup_ctr_B;
+uint64_t dedup_key_ctr_B;
+Time     arrival_ctr_B;
 // CONTAINER C
 bool ctr_C_busy= false;					// true: container C busy
 uint8_t  buf_ctr_C[BATCH_SIZE + LC];
-uint64_t com_ctr_C[BATCH_SIZE];
-uint8_t  div_ctr_C[BATCH_SIZE * DV];
+alignas(64) com_t    com_ctr_C[BATCH_SIZE];
+alignas(64) uint8_t  div_ctr_C[DV][BATCH_SIZE];
+uint32_t size_ctr_C;
+int64_t  dedup_ctr_C;
+uint64_t dedup_key_ctr_C;
+Time     arrival_ctr_C;
+
+// SURVIVOR RUNS
+// =============
+// The probe stage delivers one hit bit per shingle (all DV cofilters marked).
+// A test shingle survives when it ends a run of more than LP-L hits, that is a
+// substring of length >= LP all of whose shingles have a matching fingerprint.
+// With minimizer sampling the hit bit of a shingle is the verdict of the window
+// (LT shingles) ending there, the run threshold is then 1 window.
+#define MAX_RUNS  (1ULL << 24)	// upper limit of recorded survivor runs
+struct survivor_run {
+	uint64_t start;				// offset in S of the first shingle of the run
+	uint64_t length;			// number of shingles (the run covers length + L-1 bytes)
+};
+// run state carried across batch (and thread) boundaries
+struct run_state {
+	uint32_t threshold= LT;		// run threshold [hit bits]
+	uint32_t extent= 0;			// shingles covered before the first hit bit of a run
+	uint64_t position= 0;		// offset in S of the next shingle
+	uint64_t count= 0;			// length of the current run of hits
+	uint64_t start= 0;			// offset in S of the current run
+	uint64_t residue= 0;		// remaining number of substrings
+	uint64_t max_count= 0;		// upper limit of longest remaining substring(s)
+	uint64_t run_count= 0;		// number of survivor runs (recorded: up to MAX_RUNS)
+	vector<survivor_run> runs;	// survivor runs
+};
+// scan the hit mask of a batch (nbits shingles) for survivors
+void detect_runs(run_state &rs, const uint64_t hit_mask[], uint32_t nbits);
+// close the run still open at the end of the data
+void finish_runs(run_state &rs);
+// hash the shingles of a master file region and record them in the map or check them
+void scan_region(ifstream &string_input_stream, uint64_t first, uint64_t length, uint64_t demo_offset, bool record);
+// re-filter the survivor runs of the previous round against the current map
+void refine_runs(const run_state &survivors, ifstream &string_input_stream);
+// filter the reference string s against a reduced map of the survivors of S
+void reduce_reference(ifstream &string_input_stream);
+// write the merged regions of the runs (padded by L-1) and their index, returns the number of bytes
+uint64_t write_regions(const run_state &rs, uint64_t base, uint64_t size, string file_name);
+// filter S against the map file streamed region by region (OUT_OF_CORE)
+void out_of_core_gather(string map_file_name);
 
 // THREAD INTERFACE
 // ================
-uint64_t residue;			// remaining number of substrings
-uint64_t max_count= 0;		// upper limit of longest remaining substring(s)
+run_state test_runs;		// survivors of the test string S
+run_state reference_runs;	// two-sided reduction: reference regions of possible matches
 // hash map
 uint8_t *map;
+// sliding reference window: combined map of the generations
+uint8_t *spare_map= NULL;		// next combined map (built by the refresh thread)
+atomic<bool> refresh_ready(false);	// true: spare_map is newer than map (taken over by worker3)
+atomic<bool> refresh_stop(false);
+uint32_t latest_generation= 0;	// newest generation in the combined map
+uint32_t refresh_count= 0;		// number of combined maps taken over during the run
+time_t generation_setup_time;	// shared seed of the generations
+void refresh_thread();
+string generation_map_file_name(uint32_t generation) {
+	return map_file_name_prefix
+		+ to_string(M_DIV) + "_"
+		+ to_string(L) + "_g" + to_string(generation) + ".txt";
+}
+// combine the generations latest-GENERATIONS+1 .. latest into dest, returns the number of generations
+uint32_t combine_generations(uint8_t *dest, uint32_t latest);
+uint64_t m_map= M_COM;		// slots per cofilter of the current map (reduced map < M_COM)
+#define MAP_PAD  4	// bytes allocated beyond M_COM + M_DIV (dword gathers)
+// fingerprint family (map header)
+uint32_t fp_family;
+// shingle sampling (map header)
+uint32_t sampling;
+minimizer_window test_window;	// sliding window over the test shingles
+// filter backend (map header)
+uint32_t backend;
+uint64_t map_size;				// length of the map [bytes]
+uint64_t map_offset;			// offset of the map in the map file (length of the header)
+uint64_t filter_seed;			// hash seed of the xor filter
+uint64_t probe_count= 0;		// number of probed shingles
+// probe-result cache
+struct probe_cache_slot {
+	uint64_t com;		// common hash, bit 63: verdict (~0: empty)
+	uint64_t div;		// DV diversified hashes (byte packed)
+};
+alignas(64) probe_cache_slot probe_cache[1 << PROBE_CACHE_BITS];
+uint32_t probe_cache_bypass= 0;		// batches left to bypass the cache
+uint32_t probe_cache_backoff= 1;	// length of the next bypass [batches]
+uint64_t probe_cache_lookups= 0;
+uint64_t probe_cache_hits= 0;
+uint64_t probe_cache_bypassed= 0;	// probes that bypassed the cache
+// dedup cache
+struct dedup_entry {
+	uint64_t key;		// chunk hash
+	uint32_t first;		// first hit run of the chunk
+	uint32_t count;		// number of hit runs
+};
+struct dedup_run {
+	uint32_t start;		// first hit shingle (offset in the chunk)
+	uint32_t length;	// number of hit shingles
+};
+bool dedup_enabled= false;
+uint64_t map_id= 0;						// hash of the map header (L) and contents
+vector<dedup_entry> dedup_entries;		// cache file, sorted by key (read only during the run: worker2)
+vector<dedup_run> dedup_runs;
+vector<dedup_entry> dedup_new_entries;	// chunks filtered during the run (worker3)
+vector<dedup_run> dedup_new_runs;
+uint64_t dedup_lookups= 0;
+uint64_t dedup_hits= 0;
+uint64_t batch_hit_mask[BATCH_SIZE / 64 + 1];	// hit mask of the last checked batch (bit i: shingle j0+i)
+uint64_t chunk_hash(const uint8_t s[], uint64_t size, uint64_t seed);
+int64_t dedup_lookup(const uint8_t buffer[], uint32_t size, uint64_t &key);
+void dedup_replay(int64_t entry, uint32_t size);
+void dedup_record(uint64_t key, uint32_t size);
+string dedup_file_name();
+void load_dedup();
+void save_dedup();
+// chunk matching
+struct cdc_chunk {
+	uint64_t key;		// chunk hash
+	uint64_t offset;	// offset in s
+	uint64_t length;	// [bytes]
+};
+struct cdc_match {
+	uint64_t test_offset;		// offset in S
+	uint64_t reference_offset;	// offset in s
+	uint64_t length;			// [bytes]
+};
+struct cdc_state {
+	uint64_t gear= 0;			// gear hash
+	uint64_t start= 0;			// offset of the current chunk
+	uint32_t length= 0;			// bytes of the current chunk (staged in bytes[])
+	uint8_t  bytes[CDC_MAX_SIZE];	// current chunk (its bytes of the previous batches)
+	uint8_t  reference[CDC_MAX_SIZE];	// chunk of s with the same hash and length (byte comparison)
+};
+bool cdc_enabled= false;
+vector<cdc_chunk> cdc_chunks;			// chunk file, sorted by key (read only during the run: worker1)
+cdc_state test_chunking;				// worker1
+cdc_match cdc_ring[CDC_RING];			// matches, written by worker1, consumed by worker3 in S order
+atomic<uint64_t> cdc_pushed(0);			// matches written
+uint64_t cdc_consumed= 0;				// matches consumed
+uint64_t cdc_test_chunks= 0;			// chunks of S
+vector<cdc_match> confirmed;			// matched chunks (worker3), adjacent chunks merged
+uint64_t cdc_confirmed_bytes= 0;
+uint64_t cdc_skipped= 0;				// shingles not probed
+uint64_t cdc_collisions= 0;				// chunks of S with the hash and length of a chunk of s, but other bytes
+ifstream cdc_reference_stream;			// master file: chunks of s (worker1)
+// chunk the bytes of the batch (last: the end of S closes the current chunk)
+void cdc_scan(const uint8_t input_buffer[], uint32_t size, bool last);
+// check the batch, the shingles inside matched chunks are skipped
+void cdc_check_batch(uint32_t j0, uint32_t hash_count, com_t com_hash[], uint8_t div_hash[][BATCH_SIZE]);
+string chunk_file_name() {
+	return chunk_file_name_prefix + to_string(M_DIV) + "_" + to_string(L) + ".txt";
+}
+bool load_chunks(time_t setup_time);
+uint64_t write_confirmed(string file_name);
+// existence mode
+#define VERIFIABLE  (EXISTENCE_VERIFY && SOURCE == SOURCE_MASTER && !STREAMING && GENERATIONS == 0)
+atomic<bool> existence_found(false);	// worker3: a common substring of length >= LP is confirmed (cancels the workers)
+uint64_t existence_test_offset= 0;		// offset in S of the match
+uint64_t existence_reference_offset= 0;	// offset in s of the match (verified)
+bool existence_verified= false;			// the match was found in s (verified run, confirmed chunk)
+double existence_time= 0;				// [milliseconds] since the start of the pipeline
+uint64_t existence_candidates= 0;		// candidate runs verified
+uint64_t existence_next_run= 0;			// next closed survivor run to verify
+uint64_t existence_open_start= ~0ULL;	// start of the open run verified last
+uint64_t existence_open_windows= 0;		// its windows verified (LP bytes each)
+// worker3, after each batch: verify the new candidates, set existence_found
+void existence_check();
+// search the windows (LP bytes) of S from start in s, returns true and the offsets of a window found
+bool verify_candidate(uint64_t start, uint64_t windows, uint64_t &test_offset, uint64_t &reference_offset);
+// read size bytes of the master file at offset as the workers of scatter and gather see them (shuffled, "Demo-String")
+bool read_master(ifstream &string_input_stream, uint64_t offset, uint8_t buffer[], uint64_t size);
+void probe_cache_clear() {
+	// new map: the cached verdicts are void
+	memset(probe_cache, 0xFF, sizeof(probe_cache));
+}
+// streaming
+atomic<uint32_t> stream_batch_count(0);	// number of batches, set by worker1 at end-of-stream (0: unknown)
+uint64_t stream_bytes= 0;		// number of bytes received
+void synthetic_batch(uint64_t &state, uint8_t input_buffer[], uint32_t size);
+vector<double> batch_latency;	// latency of the batches [milliseconds]: first byte arrival .. verdict
 // cyclic permutation vector
 uint8_t shuffle[256];
 
@@ -176,31 +774,46 @@ int main() {
 	uint32_t stage_id;			// current stage
 	uint32_t batch_count;		// total number of required batches (>= 3)
 	// compatible map file: same M_COM, M_DIV and L in scatter and gather!!
-	string map_file_name= map_file_name_prefix
+	auto round_map_file_name= [](uint32_t round){
+		return (COUNTING_MAP ? counting_map_file_name_prefix : map_file_name_prefix)
 			+ to_string(M_DIV) + "_"
-			+ to_string(L) + ".txt";
+			+ to_string(L) + (round > 1 ? "_r" + to_string(round) : "") + ".txt";
+	};
+	string map_file_name= round_map_file_name(1);
 
 	// total number of batches
 	// -----------------------
 	// note that the last batch is not necessarily completely full
 	batch_count= N / BATCH_SIZE;
 	if ((N - (batch_count * BATCH_SIZE)) > 0) batch_count++;
+	if (STREAMING) batch_count= UINT32_MAX;	// streaming: known at end-of-stream
 	if (batch_count < 3) exit(10);
 
 	printf("\n");
 	printf("gather_v1 \n");
 	printf("========= \n");
-	printf("master file           : %s \n", master_string_file_name.c_str());
+	if (STREAMING) {
+		printf("stream                : %s \t(max. latency %d milliseconds) \n", stream_file_name.c_str(), MAX_LATENCY_MS);
+	} else if (SOURCE == SOURCE_SYNTHETIC) {
+		printf("source                : %s \t(seed %llx) \n", source_name[SOURCE], SYNTHETIC_SEED);
+	} else {
+		printf("master file           : %s \n", master_string_file_name.c_str());
+	}
+	if (SINK != SINK_PROBE || !HASH_STAGE) {
+		printf("sink                  : %s \t(hash stage %s) \n", sink_name[SINK], HASH_STAGE ? "on" : "off");
+	}
 	printf("map    file           : %s \n", map_file_name.c_str());
 	printf("string s length ns    : %llu \t(reference string s) \n", ns);
 	printf("string S length NS    : %llu \t(test string S) \n", NS);
 	printf("prefix  length LP     : %d \n", LP);
 	printf("shingle length L      : %d \n", L);
 	printf("carry   length LC     : %d \n", LC);
-	printf("batch count           : %d \n", batch_count);
+	if (!STREAMING) printf("batch count           : %d \n", batch_count);
 	printf("batch size            : %d \n", BATCH_SIZE);
 	printf("common modulus        : %llu \n", M_COM);
 	printf("diversity modulus     : %llu \n", M_DIV);
+	printf("shingling engine      : %s \n", engine_name[ENGINE]);
+	printf("filtering rounds      : %d \n", ROUNDS);
 	printf("expected cross repetitions of length LP: \n");
 	printf(" - Ecr(sxS, LP)       : %12.1f \n", pow(1.0/256.0, LP)*ns*NS );
 	printf(" - Ecr(sxS, LP) / NS  : %12.9f \n", pow(1.0/256.0, LP)*ns );
@@ -208,7 +821,8 @@ int main() {
 	fflush(stdout);
 
     // reset residue
-	residue= 0;
+	test_runs= run_state();
+	probe_count= 0;
 	// reset time expenditures
     worker1_waiting_time= 0;
     worker1_process_time= 0;
@@ -219,13 +833,52 @@ int main() {
 
 	// hash map allocation
 	// -------------------
-	map= (uint8_t *)malloc(M_COM + M_DIV); if (map == NULL) exit(11);
+	// (allocated by load_hash_map: the size depends on the filter backend)
+	map= NULL;
 	// load hash map from file
 	// -----------------------
 	printf("load hash map ... \n");
 	fflush(stdout);
-	time_t setup_time= load_hash_map(map_file_name);
+	time_t setup_time;
+	if (GENERATIONS > 0) {
+		// newest generation (header, allocation), combined with the older generations of the window
+		for (uint32_t g= 1; g <= MAX_GENERATION; g++) {
+			ifstream generation_stream(generation_map_file_name(g), ios::binary);
+			if (generation_stream) latest_generation= g;
+		}
+		if (latest_generation == 0) {
+			cerr << "Can't open any generation map file (input)!";
+			exit(26);
+		}
+		setup_time= load_hash_map(generation_map_file_name(latest_generation), 1);
+		generation_setup_time= setup_time;
+		if (backend != BACKEND_BITMAP) exit(28);
+		printf("generations           : %d of the window %d .. %d \n", combine_generations(map, latest_generation),
+				max((int)latest_generation - GENERATIONS + 1, 1), latest_generation);
+		spare_map= alloc_map(M_COM + M_DIV + MAP_PAD); if (spare_map == NULL) exit(11);
+		memset(spare_map + M_COM + M_DIV, 0b11111111, MAP_PAD);
+	} else {
+		setup_time= load_hash_map(map_file_name, 1);
+	}
 	printf("map setup_time :  %s \n", ctime(&setup_time));
+	printf("fingerprint family    : %s \n", fp_family_name[fp_family]);
+	printf("shingle sampling      : %s \n", sampling_name[sampling]);
+	printf("filter backend        : %s \t(%llu bytes, %d map reads per query) \n", backend_name[backend], map_size, backend_reads[backend]);
+	if (m_map < M_COM) printf("sparse map            : folded to %llu slots per cofilter \n", m_map);
+	if (OUT_OF_CORE) {
+		if (backend != BACKEND_BITMAP || sampling != SAMPLE_ALL || m_map < M_COM) {
+			printf("out-of-core gather: bitmap (not folded) of all shingles required \n");
+			fflush(stdout);
+			exit(28);
+		}
+		printf("out-of-core           : %d regions of %llu bytes, slabs of %llu shingles \n",
+				REGIONS, (M_COM + REGIONS - 1) / REGIONS + M_DIV, SLAB_SIZE);
+	}
+	if (sampling == SAMPLE_MINIMIZER) {
+		// one hit bit per window
+		test_runs.threshold= 1;
+		test_runs.extent= LT - 1;
+	}
 	// printf("first 20 map values: \n");
 	// for (uint32_t i= 0; i<20; i++) printf(" %d ", map[i]);
 	// printf("\n");
@@ -239,9 +892,29 @@ int main() {
 	// for (uint32_t i= 0; i<20; i++) printf(" %d ", shuffle[i]);
 	// printf("\n");
 
+	if (PROBE_CACHE) probe_cache_clear();
+	if (DEDUP) {
+		// map id: header and contents (a map rebuilt with the same header gets a new id)
+		dedup_enabled= (sampling == SAMPLE_ALL);
+		if (dedup_enabled) {
+			map_id= chunk_hash(map, map_size, map_id);
+			load_dedup();
+		}
+		printf("dedup cache           : %s \t(%llu chunks) \n", dedup_enabled ? dedup_file_name().c_str() : "off, all shingles required",
+				(uint64_t)dedup_entries.size());
+	}
+	if (CDC) {
+		// chunks of s recorded by scatter together with the map (same setup time: same shuffle)
+		cdc_enabled= (sampling == SAMPLE_ALL && load_chunks(setup_time));
+		if (cdc_enabled) cdc_reference_stream.open(master_string_file_name, ios::in|ios::binary);
+		printf("chunk matching        : %s \t(%llu chunks of s) \n", cdc_enabled ? chunk_file_name().c_str() : "off",
+				(uint64_t)cdc_chunks.size());
+	}
+
 	// elapsed time
 	double elapsed_time= 0;
 	Time start_elapsed_time= start_timer();
+	trace_epoch= start_elapsed_time;
 	// work time
 	double work_time= 0;
 	Time start_work_time;
@@ -252,69 +925,252 @@ int main() {
 	double overhead_time= 0;
 	Time start_overhead_time;
 
-	// start threads (they will wait for the first start-signal)
-	start_overhead_time= start_timer();
-    thread worker1(worker1_thread);
-    thread worker2(worker2_thread);
-    thread worker3(worker3_thread);
-    overhead_time+= get_elapsed_time(start_overhead_time);
-
-    // schedule threads
-    // ================
-    // first stage: 1A (worker1 processes container A)
-	{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
-	{unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_scheduler_enabled;}); cv1_scheduler_enabled= false;}
-	// second stage: 1B, 2A
-	{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
-	{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
-	{unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_scheduler_enabled;}); cv1_scheduler_enabled= false;}
-	{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_scheduler_enabled;}); cv2_scheduler_enabled= false;}
-	// third stage: 1C, 2B, 3A
-	// etc...
-	for (stage_id= 3; stage_id <= batch_count; stage_id++) {
-		//p cout << "send start-signal to workers \n"; fflush(stdout);
-		// <== send start-signal to workers
-		start_schedule_time= start_timer();
+	if (OUT_OF_CORE) {
+		// no pipeline: slab by slab, the map is streamed from the map file
+		out_of_core_gather(map_file_name);
+	} else {
+		// start threads (they will wait for the first start-signal)
+		start_overhead_time= start_timer();
+	    thread worker1(worker1_thread);
+	    thread worker2(worker2_thread);
+	    thread worker3(worker3_thread);
+	    thread refresher;
+	    if (GENERATIONS > 0) refresher= thread(refresh_thread);
+	    thread reporter;
+	    if (PROGRESS_MS > 0) reporter= thread(progress_thread, STREAMING ? 0 : NS);
+	    overhead_time+= get_elapsed_time(start_overhead_time);
+
+	    // schedule threads
+	    // ================
+	    // first stage: 1A (worker1 processes container A)
+		{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
+		{unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_scheduler_enabled;}); cv1_scheduler_enabled= false;}
+		// second stage: 1B, 2A
 		{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
 		{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
-		{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
-		schedule_time+= get_elapsed_time(start_schedule_time);
-		//p cout << "wait for end-signals from workers \n"; fflush(stdout);
-		// <== wait for end-signal from workers
-		start_work_time= start_timer();
 		{unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_scheduler_enabled;}); cv1_scheduler_enabled= false;}
 		{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_scheduler_enabled;}); cv2_scheduler_enabled= false;}
-		{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
-		work_time+= get_elapsed_time(start_work_time);
-	}
-	// second last stage (batch_count + 1): 2x, 3x
-	{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
-	{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
-	{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_scheduler_enabled;}); cv2_scheduler_enabled= false;}
-	{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
-	// last stage (batch_count + 2): 3y
-	{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
-	{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
-
-	// end threads
-	start_overhead_time= start_timer();
-    worker1.join();
-    worker2.join();
-    worker3.join();
-    overhead_time+= get_elapsed_time(start_overhead_time);
+		// third stage: 1C, 2B, 3A
+		// etc...
+		for (stage_id= 3; stage_id <= batch_count; stage_id++) {
+			//p cout << "send start-signal to workers \n"; fflush(stdout);
+			// <== send start-signal to workers
+			start_schedule_time= start_timer();
+			{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
+			{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
+			{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
+			schedule_time+= get_elapsed_time(start_schedule_time);
+			trace(0, TRACE_SIGNAL, ' ', stage_id, start_schedule_time);
+			//p cout << "wait for end-signals from workers \n"; fflush(stdout);
+			// <== wait for end-signal from workers
+			start_work_time= start_timer();
+			{unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_scheduler_enabled;}); cv1_scheduler_enabled= false;}
+			{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_scheduler_enabled;}); cv2_scheduler_enabled= false;}
+			{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
+			work_time+= get_elapsed_time(start_work_time);
+			trace(0, TRACE_STAGE, ' ', stage_id, start_work_time);
+			// streaming: the batch count is known as soon as worker1 has read end-of-stream
+			if (STREAMING && stream_batch_count > 0) batch_count= stream_batch_count;
+			// existence mode: the answer is known
+			if (EXISTENCE && existence_found) break;
+		}
+		if (EXISTENCE && existence_found) {
+			// cancel: the workers see the flag at their next start-signal and return
+			{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
+			{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
+			{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
+		} else {
+			// second last stage (batch_count + 1): 2x, 3x
+			{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
+			{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
+			{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_scheduler_enabled;}); cv2_scheduler_enabled= false;}
+			{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
+			// last stage (batch_count + 2): 3y
+			{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
+			{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
+		}
+
+		// end threads
+		start_overhead_time= start_timer();
+	    worker1.join();
+	    worker2.join();
+	    worker3.join();
+	    if (GENERATIONS > 0) {
+	    	refresh_stop= true;
+	    	refresher.join();
+	    	refresh_ready= false;
+	    	printf("combined maps taken over during the run: %d \t(newest generation %d) \n", refresh_count, latest_generation);
+	    }
+	    if (PROGRESS_MS > 0) {
+	    	progress_stop= true;
+	    	reporter.join();
+	    }
+	    overhead_time+= get_elapsed_time(start_overhead_time);
+	}
 	elapsed_time= get_elapsed_time(start_elapsed_time);
+	if (cdc_enabled) {
+		printf("chunk matching        : %llu of %llu chunks of S found in s \t(%llu shingles not probed, %llu hash collisions) \n",
+				cdc_consumed, cdc_test_chunks, cdc_skipped, cdc_collisions);
+	}
+	if (dedup_enabled) {
+		printf("dedup cache           : %llu of %llu chunks reused \t(%llu new chunks) \n", dedup_hits, dedup_lookups,
+				(uint64_t)dedup_new_entries.size());
+		save_dedup();
+	}
+	if (TRACE) {
+		uint64_t events= write_trace();
+		printf("trace file            : %s \t(%llu events) \n", trace_file_name.c_str(), events);
+	}
+	finish_runs(test_runs);
+	// existence mode: the run still open at the end of S
+	if (EXISTENCE && !existence_found) existence_check();
+	// number of test shingles (streaming: received)
+	uint64_t test_shingles= STREAMING ? test_runs.position : N;
+	uint64_t test_bytes= STREAMING ? stream_bytes : NS;
+	if (EXISTENCE && existence_found && !STREAMING) {
+		// cancelled: processed part of S
+		test_shingles= test_runs.position;
+		test_bytes= progress_bytes.load();
+	}
+
+	// filtering rounds
+	// ================
+	// round k > 1: fresh seed (map setup time) and base set, the input of the round
+	// are the survivor runs of round k-1 re-read from the master file
+	printf("\n");
+	printf("round %d  : %llu residue, %llu survivor runs \n", 1, test_runs.residue, test_runs.run_count);
+	ifstream string_input_stream;
+	if (SOURCE == SOURCE_MASTER && SINK == SINK_PROBE) {
+		string_input_stream.open(master_string_file_name, ios::in|ios::binary);
+		if (!string_input_stream) cerr << "Can't open master file!";
+	}
+	if (ROUNDS > 1) {
+		for (uint32_t round= 2; round <= ROUNDS; round++) {
+			if (test_runs.run_count > MAX_RUNS) {
+				printf("round %d  : skipped, more than %llu survivor runs \n", round, MAX_RUNS);
+				break;
+			}
+			Time start_round_time= start_timer();
+			setup_time= load_hash_map(round_map_file_name(round), round);
+			if (sampling != SAMPLE_ALL) {
+				printf("map of round %d: all shingles required \n", round);
+				fflush(stdout);
+				exit(29);
+			}
+			P_DIV= p_div(B_DIV_SET[round-1]);
+			mt19937 mt_rand(setup_time);
+			rcp_generator(mt_rand, shuffle);
+			run_state survivors= test_runs;
+			test_runs= run_state();
+			refine_runs(survivors, string_input_stream);
+			printf("round %d  : %llu residue, %llu survivor runs \t(%.0f milliseconds) \n",
+					round, test_runs.residue, test_runs.run_count, get_elapsed_time(start_round_time));
+		}
+	}
+	fflush(stdout);
+
+	// two-sided reduction
+	// ===================
+	double reduction_time= 0;
+	if (TWO_SIDED && test_runs.run_count > MAX_RUNS) {
+		// the survivors are not all recorded: s remains the reference region as a whole
+		printf("two-sided reduction: skipped, more than %llu survivor runs \n", MAX_RUNS);
+		reference_runs= run_state();
+		reference_runs.runs.push_back({0, ns - LC});
+		reference_runs.run_count= 1;
+	} else if (TWO_SIDED) {
+		Time start_reduction_time= start_timer();
+		reduce_reference(string_input_stream);
+		reduction_time= get_elapsed_time(start_reduction_time);
+	}
+	string_input_stream.close();
+
+	// reduced problem
+	// ===============
+	double write_time= 0;
+	uint64_t reduced_bytes= 0;
+	uint64_t reduced_reference_bytes= 0;
+	if (WRITE_REDUCED && !existence_found) {
+		Time start_write_time= start_timer();
+		reduced_bytes= write_regions(test_runs, ns, NS, reduced_file_name_prefix + "S");
+		if (TWO_SIDED) reduced_reference_bytes= write_regions(reference_runs, 0, ns, reduced_file_name_prefix + "s");
+		write_time= get_elapsed_time(start_write_time);
+	}
+	if (cdc_enabled) write_confirmed(reduced_file_name_prefix + "confirmed.txt");
+	uint64_t residue= test_runs.residue;
+	if (SINK == SINK_CHECKSUM) printf("checksum : %016llx \t(hashes of %llu test shingles) \n", sink_checksum, test_runs.position);
 
 	// results
 	// =======
 	printf("\n");
 	printf("results \n");
 	printf("------- \n");
-	printf("longest residual substring(s)  : %llu [bytes] \t(upper limit) \n", max_count + L-1);
+	if (EXISTENCE) {
+		if (existence_found) {
+			printf("common substring >= LP         : yes \t(offset in S %llu, ", existence_test_offset);
+			if (existence_verified) printf("offset in s %llu, verified) \n", existence_reference_offset);
+			else printf("unverified) \n");
+			printf(" - found after                 : %9.0f [milliseconds] \t(%llu of %llu bytes of S read) \n",
+					existence_time, test_bytes, NS);
+		} else if (test_runs.run_count > MAX_RUNS) {
+			// the runs beyond MAX_RUNS are not recorded: candidates not verified
+			printf("common substring >= LP         : unknown \t(more than %llu candidate runs, not all verified) \n", MAX_RUNS);
+		} else {
+			printf("common substring >= LP         : no \n");
+		}
+		printf(" - candidate runs              : %llu \t(%s) \n", existence_candidates, VERIFIABLE ? "verified against s" : "unverified");
+	}
+	printf("longest residual substring(s)  : %llu [bytes] \t(upper limit) \n", test_runs.max_count + L-1);
 	printf("number of residual substrings  : %llu (residue)\n", residue);
+	printf("number of survivor runs        : %llu \t(substrings of length >= LP) \n", test_runs.run_count);
+	if (cdc_enabled) {
+		printf("confirmed common substrings    : %llu \t(%llu bytes, matched chunks: %s) \n", (uint64_t)confirmed.size(),
+				cdc_confirmed_bytes, (reduced_file_name_prefix + "confirmed.txt").c_str());
+	}
 	printf("filtration ratio :\n");
-	printf(" - measured               : %11.9f \t(residue / N)\n", (float)residue / N);
-	printf(" - expected optimum       : %11.9f \t((1 - 1/e) ^ (DV*(LP-L+1)) ) \n", pow(0.63212, DV*(LP-L+1)));
-	printf("extrapolated Nlim / n     : %12.1f \n", (float)N / (float)residue);
+	printf(" - measured               : %11.9f \t(residue / N)\n", (float)residue / test_shingles);
+	if (sampling == SAMPLE_MINIMIZER) {
+		// a window survives when its minimizer occurs in s (true L-byte match) or is a false positive
+		printf(" - expected (upper limit) : %11.9f \t((1 - exp(-ns/256^L)) + (1 - exp(-d*ns/M_COM)) ^ DV, d= 2/(LT+1)) \n",
+				1.0 - exp(-(double)ns / pow(256.0, L)) + pow(1.0 - exp(-2.0 / (LT+1) * ns / M_COM), DV));
+	} else {
+		printf(" - expected optimum       : %11.9f \t((1 - 1/e) ^ (DV*(LP-L+1)) ) \n", pow(0.63212, DV*(LP-L+1)));
+	}
+	printf("probes per test shingle   : %11.9f \t(probed shingles / N)\n", (float)probe_count / test_shingles);
+	printf("map reads per test shingle: %11.9f \t(probes * %d / N, %s)\n", (float)probe_count * backend_reads[backend] / test_shingles,
+			backend_reads[backend], backend_name[backend]);
+	if (PROBE_CACHE && probe_cache_lookups + probe_cache_bypassed > 0) {
+		printf("probe cache hit rate      : %11.9f \t(%llu of %llu lookups, %llu probes bypassed) \n",
+				(double)probe_cache_hits / max(probe_cache_lookups, (uint64_t)1), probe_cache_hits, probe_cache_lookups, probe_cache_bypassed);
+	}
+	printf("extrapolated Nlim / n     : %12.1f \n", (float)test_shingles / (float)residue);
+	if (STREAMING && !batch_latency.empty()) {
+		// latency percentiles (first byte arrival .. survivor verdict of its batch)
+		qsort(batch_latency.data(), batch_latency.size(), sizeof(double),
+				[](const void *a, const void *b){ double d= *(const double *)a - *(const double *)b; return (d > 0) - (d < 0); });
+		size_t batches= batch_latency.size();
+		printf("streaming: %llu bytes in %llu batches (mean %.0f bytes) \n", stream_bytes, (uint64_t)batches, (double)stream_bytes / batches);
+		printf(" - latency p50            : %9.3f [milliseconds] \t(first byte arrival .. verdict) \n", batch_latency[(batches - 1) / 2]);
+		printf(" - latency p99            : %9.3f [milliseconds] \n", batch_latency[(batches - 1) * 99 / 100]);
+		printf(" - latency max            : %9.3f [milliseconds] \n", batch_latency[batches - 1]);
+	}
+	if (TWO_SIDED) {
+		uint64_t reference_bytes= 0;
+		for (const survivor_run &run : reference_runs.runs) reference_bytes+= run.length + L-1;
+		printf("two-sided reduction (reference string s): \n");
+		printf(" - reference regions      : %llu \t(substrings of length >= LP) \n", reference_runs.run_count);
+		printf(" - residual bytes         : %llu \t(%11.9f of ns) \n", reference_bytes, (double)reference_bytes / ns);
+		printf(" - reduced map            : %llu slots per cofilter \n", m_map);
+		printf(" - reduction time         : %9.0f [milliseconds] \n", reduction_time);
+	}
+	if (WRITE_REDUCED) {
+		printf("reduced problem (regions padded by L-1 and merged): \n");
+		printf(" - test file              : %s \t(%llu bytes) \n", (reduced_file_name_prefix + "S.txt").c_str(), reduced_bytes);
+		if (TWO_SIDED) {
+			printf(" - reference file         : %s \t(%llu bytes) \n", (reduced_file_name_prefix + "s.txt").c_str(), reduced_reference_bytes);
+		}
+		printf(" - write time             : %9.0f [milliseconds] \n", write_time);
+	}
 
 	// time expenditure
 	// ================
@@ -337,15 +1193,81 @@ int main() {
 	printf("\n");
 	printf("throughput with ns= %llu \t(reference string) \n", ns);
 	printf("---------- \n");
-	printf("filtration rate: %6.0f [mega bytes / second] \t(NS / elapsed time)\n", (float)NS / (1000.0 * elapsed_time));
+	printf("filtration rate: %6.0f [mega bytes / second] \t(NS / elapsed time)\n", (float)test_bytes / (1000.0 * elapsed_time));
+	printf("hashing rate   : %6.3f [giga bytes / second] \t(NS / worker2 process time, one core)\n", (float)test_bytes / (1000000.0 * worker2_process_time));
+	printf("source rate    : %6.3f [giga bytes / second] \t(NS / worker1 process time, %s)\n", (float)test_bytes / (1000000.0 * worker1_process_time),
+			STREAMING ? "stream" : source_name[SOURCE]);
+	printf("sink rate      : %6.3f [giga bytes / second] \t(NS / worker3 process time, %s)\n", (float)test_bytes / (1000000.0 * worker3_process_time),
+			sink_name[SINK]);
 	fflush(stdout);
 }
 
+// streaming reader
+// ----------------
+// a batch is flushed when it is full, when MAX_LATENCY_MS have elapsed since the arrival
+// of its first byte, or at end-of-stream. The first batch waits for LC bytes (carry)
+// unless the stream ends. While the verdicts of earlier batches are pending (two stages),
+// an idle stream yields an empty batch after MAX_LATENCY_MS, so the stages keep advancing.
+// After end-of-stream the reader returns empty batches.
+#if STREAMING
+uint32_t read_stream(
+	int stream_fd,				// input : stream file descriptor
+	uint8_t input_buffer[],		// output: batch (at most BATCH_SIZE bytes)
+	Time &arrival,				// output: arrival time of the first byte
+	bool &stream_ended)			// in/out: end-of-stream
+{
+	static bool first_batch= true;
+	static uint32_t pending= 0;	// stages until the verdict of the last non-empty batch
+	uint32_t size= 0;
+	arrival= start_timer();
+	while (!stream_ended && size < BATCH_SIZE) {
+		int timeout= -1;		// idle, no verdict pending: wait for the first byte
+		if (size == 0 ? pending > 0 : !(first_batch && size < LC)) {
+			timeout= MAX_LATENCY_MS - (int)get_elapsed_time(arrival);
+			if (timeout <= 0) break;
+		}
+		pollfd pfd= {stream_fd, POLLIN, 0};
+		if (poll(&pfd, 1, timeout) == 0) break;		// flush timer
+		ssize_t k= read(stream_fd, input_buffer + size, BATCH_SIZE - size);
+		if (k < 0) exit(12);
+		if (k == 0) stream_ended= true;
+		else {
+			if (size == 0) arrival= start_timer();
+			size+= k;
+		}
+	}
+	if (size > 0) {
+		first_batch= false;
+		pending= 2;
+	} else if (pending > 0) pending--;
+	stream_bytes+= size;
+	return(size);
+}
+#endif
+
+// synthetic source
+// ----------------
+// IID bytes at memory speed (xorshift64*, 8 bytes per step), replacing the read of the master file
+void synthetic_batch(
+	uint64_t &state,			// in/out: generator state
+	uint8_t input_buffer[],		// output: batch
+	uint32_t size)				// input : batch size
+{
+	uint64_t x;
+	for (uint32_t j= 0; j < size; j+= 8) {
+		state^= state >> 12;
+		state^= state << 25;
+		state^= state >> 27;
+		x= state * 0x2545F4914F6CDD1DULL;
+		memcpy(input_buffer + j, &x, min(size - j, 8U));
+	}
+}
+
 // ****************************************************************************************************************************
 //4
 void worker1_thread()
 {
-	SetThreadAffinityMask(GetCurrentThread(), 7ULL);
+	SetThreadAffinityMask(GetCurrentThread(), AFFINITY_PIPELINE);
 	Time start_time;			// start of time measurement
 	uint8_t *buffer;			// byte string buffer
 	uint8_t *input_buffer;		// start at: buffer + LC (carry length)
@@ -356,6 +1278,11 @@ void worker1_thread()
 	uint32_t last_batch_size;	// batch size of the last batch
 	uint32_t batch_count;		// total number of required batches
 	uint32_t demo_batch_id;		// "Demo-String"
+#if STREAMING
+	int stream_fd;				// stream file descriptor
+	bool stream_ended= false;	// end-of-stream
+#endif
+	uint64_t synthetic_state= SYNTHETIC_SEED;	// SOURCE_SYNTHETIC: generator state
 
 	batch_count= N / BATCH_SIZE;
 	demo_batch_id= batch_count / 3;
@@ -371,26 +1298,41 @@ void worker1_thread()
 	}
 
 	// attach input stream to master file
-	ifstream string_input_stream(master_string_file_name, ios::in|ios::binary|ios::ate);
-	// check stream status
-	if (!string_input_stream) cerr << "Can't open master file!";
-
-	// get/check length of master file
-	// (during testing, the master file may contain more than ns+NS bytes)
-	string_input_stream.seekg (0, string_input_stream.end);
-	// check file size:
-	if ((uint64_t)string_input_stream.tellg() < ns+NS) {
-		printf("master file length < ns+NS : %llu, %llu \n", ns, NS);
-		fflush(stdout);
+	ifstream string_input_stream;
+#if STREAMING
+	// open the stream: the batches are variable in size, the batch count is unknown
+	stream_fd= (stream_file_name == "-") ? 0 : open(stream_file_name.c_str(), O_RDONLY);
+	if (stream_fd < 0) {
+		cerr << "Can't open stream!";
 		exit(12);
 	}
-	fflush(stdout);
+	batch_count= UINT32_MAX;
+	demo_batch_id= UINT32_MAX;
+#else
+	if (SOURCE == SOURCE_MASTER) {
+		string_input_stream.open(master_string_file_name, ios::in|ios::binary|ios::ate);
+		// check stream status
+		if (!string_input_stream) cerr << "Can't open master file!";
+
+		// get/check length of master file
+		// (during testing, the master file may contain more than ns+NS bytes)
+		string_input_stream.seekg (0, string_input_stream.end);
+		// check file size:
+		if ((uint64_t)string_input_stream.tellg() < ns+NS) {
+			printf("master file length < ns+NS : %llu, %llu \n", ns, NS);
+			fflush(stdout);
+			exit(12);
+		}
+		fflush(stdout);
+
+		// set position of the input stream at the begin of the test string S
+		// after the reference string s (length ns)
+		string_input_stream.seekg (ns, string_input_stream.beg);
+	}
+#endif
 
 	// set first artificial carry (skipped by worker3 -> skip_first_carry)
 	// -------------------------------------------------------------------
-	// set position of the input stream at the begin of the test string S
-	// after the reference string s (length ns)
-	string_input_stream.seekg (ns, string_input_stream.beg);
 	// locate current carry buffer
 	carry_buffer= buf_ctr_C + BATCH_SIZE;
 	// fill carry with dummy values
@@ -408,6 +1350,13 @@ void worker1_thread()
 	  start_time= start_timer();
 	  {unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_worker1_enabled;}); cv1_worker1_enabled= false;}
 	  worker1_waiting_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_WAIT, 'A', batch_id, start_time);
+	  if (EXISTENCE && existence_found) {
+	  	// existence confirmed: cancelled (end-signal, no further batches)
+	  	{lock_guard<mutex> lk(mx1); cv1_scheduler_enabled= true;} cv1.notify_one();
+	  	cout << "worker1 cancelled on A \n"; fflush(stdout);
+	  	return;
+	  }
 	  start_time= start_timer();
 
 	  //p cout << "worker1 processes container A \n"; fflush(stdout);
@@ -424,10 +1373,24 @@ void worker1_thread()
 	  carry_buffer= buffer + BATCH_SIZE;
 	  // define current input buffer
 	  input_buffer= buffer + LC;
-	  // fill input buffer
-	  string_input_stream.read((char *)input_buffer, batch_size);
-	  // check number of bytes read
-	  if (batch_size != string_input_stream.gcount()) exit(14);
+#if STREAMING
+	  // fill input buffer from the stream (variable batch size, the carry ends the batch)
+	  batch_size= read_stream(stream_fd, input_buffer, arrival_ctr_A, stream_ended);
+	  size_ctr_A= batch_size;
+	  carry_buffer= buffer + batch_size;
+	  // end-of-stream: this batch is the last one (at least 3 batches fill the pipeline)
+	  if (stream_ended) stream_batch_count= max(batch_id, 3U);
+#else
+	  if (SOURCE == SOURCE_SYNTHETIC) {
+		  // generate input buffer
+		  synthetic_batch(synthetic_state, input_buffer, batch_size);
+	  } else {
+		  // fill input buffer
+		  string_input_stream.read((char *)input_buffer, batch_size);
+		  // check number of bytes read
+		  if (batch_size != string_input_stream.gcount()) exit(14);
+	  }
+#endif
 	  // shuffle
 	  for (uint32_t j= 0; j < batch_size; j++) {
 		  input_buffer[j]= shuffle[input_buffer[j]];
@@ -446,6 +1409,7 @@ void worker1_thread()
 		  }
 	  }
 //*/
+	  if (cdc_enabled) cdc_scan(input_buffer, batch_size, batch_id == batch_count);
 
 	  // this_thread::sleep_for(chrono::milliseconds(200));
 	  //p cout << "worker1 completed container A \n"; fflush(stdout);
@@ -457,8 +1421,10 @@ void worker1_thread()
 	  {lock_guard<mutex> lk(mx1); cv1_scheduler_enabled= true;} cv1.notify_one();
 
 	  worker1_process_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_PROCESS, 'A', batch_id, start_time);
+	  progress_add(progress_bytes, batch_size);
 
-	  if (batch_id == batch_count) {
+	  if (batch_id == (STREAMING ? stream_batch_count.load() : batch_count)) {
 		  // the current batch was the last one
 		  cout << "worker1 terminates on A \n"; fflush(stdout);
 		  return;
@@ -477,6 +1443,13 @@ void worker1_thread()
 	  start_time= start_timer();
 	  {unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_worker1_enabled;}); cv1_worker1_enabled= false;}
 	  worker1_waiting_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_WAIT, 'B', batch_id, start_time);
+	  if (EXISTENCE && existence_found) {
+	  	// existence confirmed: cancelled (end-signal, no further batches)
+	  	{lock_guard<mutex> lk(mx1); cv1_scheduler_enabled= true;} cv1.notify_one();
+	  	cout << "worker1 cancelled on B \n"; fflush(stdout);
+	  	return;
+	  }
 	  start_time= start_timer();
 
 	  //p cout << "worker1 processes container B \n"; fflush(stdout);
@@ -493,10 +1466,24 @@ void worker1_thread()
 	  carry_buffer= buffer + BATCH_SIZE;
 	  // define current input buffer
 	  input_buffer= buffer + LC;
-	  // fill input buffer
-	  string_input_stream.read((char *)input_buffer, batch_size);
-	  // check number of bytes read
-	  if (batch_size != string_input_stream.gcount()) exit(16);
+#if STREAMING
+	  // fill input buffer from the stream (variable batch size, the carry ends the batch)
+	  batch_size= read_stream(stream_fd, input_buffer, arrival_ctr_B, stream_ended);
+	  size_ctr_B= batch_size;
+	  carry_buffer= buffer + batch_size;
+	  // end-of-stream: this batch is the last one (at least 3 batches fill the pipeline)
+	  if (stream_ended) stream_batch_count= max(batch_id, 3U);
+#else
+	  if (SOURCE == SOURCE_SYNTHETIC) {
+		  // generate input buffer
+		  synthetic_batch(synthetic_state, input_buffer, batch_size);
+	  } else {
+		  // fill input buffer
+		  string_input_stream.read((char *)input_buffer, batch_size);
+		  // check number of bytes read
+		  if (batch_size != string_input_stream.gcount()) exit(16);
+	  }
+#endif
 	  // shuffle
 	  for (uint32_t j= 0; j < batch_size; j++) {
 		  input_buffer[j]= shuffle[input_buffer[j]];
@@ -515,6 +1502,7 @@ void worker1_thread()
 		  }
 	  }
 //*/
+	  if (cdc_enabled) cdc_scan(input_buffer, batch_size, batch_id == batch_count);
 
 	  // this_thread::sleep_for(chrono::milliseconds(200));
 	  //p cout << "worker1 completed container B \n"; fflush(stdout);
@@ -526,8 +1514,10 @@ void worker1_thread()
 	  {lock_guard<mutex> lk(mx1); cv1_scheduler_enabled= true;} cv1.notify_one();
 
 	  worker1_process_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_PROCESS, 'B', batch_id, start_time);
+	  progress_add(progress_bytes, batch_size);
 
-	  if (batch_id == batch_count) {
+	  if (batch_id == (STREAMING ? stream_batch_count.load() : batch_count)) {
 		  // the current batch was the last one
 		  cout << "worker1 terminates on B \n"; fflush(stdout);
 		  return;
@@ -546,6 +1536,13 @@ void worker1_thread()
 	  start_time= start_timer();
 	  {unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_worker1_enabled;}); cv1_worker1_enabled= false;}
 	  worker1_waiting_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_WAIT, 'C', batch_id, start_time);
+	  if (EXISTENCE && existence_found) {
+	  	// existence confirmed: cancelled (end-signal, no further batches)
+	  	{lock_guard<mutex> lk(mx1); cv1_scheduler_enabled= true;} cv1.notify_one();
+	  	cout << "worker1 cancelled on C \n"; fflush(stdout);
+	  	return;
+	  }
 	  start_time= start_timer();
 
 	  //p cout << "worker1 processes container C \n"; fflush(stdout);
@@ -562,10 +1559,24 @@ void worker1_thread()
 	  carry_buffer= buffer + BATCH_SIZE;
 	  // define current input buffer
 	  input_buffer= buffer + LC;
-	  // fill input buffer
-	  string_input_stream.read((char *)input_buffer, batch_size);
-	  // check number of bytes read
-	  if (batch_size != string_input_stream.gcount()) exit(18);
+#if STREAMING
+	  // fill input buffer from the stream (variable batch size, the carry ends the batch)
+	  batch_size= read_stream(stream_fd, input_buffer, arrival_ctr_C, stream_ended);
+	  size_ctr_C= batch_size;
+	  carry_buffer= buffer + batch_size;
+	  // end-of-stream: this batch is the last one (at least 3 batches fill the pipeline)
+	  if (stream_ended) stream_batch_count= max(batch_id, 3U);
+#else
+	  if (SOURCE == SOURCE_SYNTHETIC) {
+		  // generate input buffer
+		  synthetic_batch(synthetic_state, input_buffer, batch_size);
+	  } else {
+		  // fill input buffer
+		  string_input_stream.read((char *)input_buffer, batch_size);
+		  // check number of bytes read
+		  if (batch_size != string_input_stream.gcount()) exit(18);
+	  }
+#endif
 	  // shuffle
 	  for (uint32_t j= 0; j < batch_size; j++) {
 		  input_buffer[j]= shuffle[input_buffer[j]];
@@ -584,6 +1595,7 @@ void worker1_thread()
 		  }
 	  }
 //*/
+	  if (cdc_enabled) cdc_scan(input_buffer, batch_size, batch_id == batch_count);
 
 	  // this_thread::sleep_for(chrono::milliseconds(200));
 	  //p cout << "worker1 completed container C \n"; fflush(stdout);
@@ -595,8 +1607,10 @@ void worker1_thread()
 	  {lock_guard<mutex> lk(mx1); cv1_scheduler_enabled= true;} cv1.notify_one();
 
 	  worker1_process_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_PROCESS, 'C', batch_id, start_time);
+	  progress_add(progress_bytes, batch_size);
 
-	  if (batch_id == batch_count) {
+	  if (batch_id == (STREAMING ? stream_batch_count.load() : batch_count)) {
 		  // the current batch was the last one
 		  cout << "worker1 terminates on C \n"; fflush(stdout);
 		  return;
@@ -612,7 +1626,7 @@ void worker1_thread()
 //2
 void worker2_thread()
 {
-	SetThreadAffinityMask(GetCurrentThread(), 7ULL);
+	SetThreadAffinityMask(GetCurrentThread(), AFFINITY_PIPELINE);
 	Time start_time;			// start of time measurement
 	uint32_t batch_id;			// current batch
 	uint32_t batch_size;		// current batch size
@@ -623,6 +1637,7 @@ void worker2_thread()
 	last_batch_size= N - (batch_count * BATCH_SIZE);
 	if (last_batch_size > 0) batch_count++;
 	else last_batch_size= BATCH_SIZE;
+	if (STREAMING) batch_count= UINT32_MAX;	// streaming: the batch size is taken from the container
 	if (batch_count == 1) {
 		// the first batch is also the last one
 		batch_size= last_batch_size;
@@ -641,6 +1656,13 @@ void worker2_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_worker2_enabled;}); cv2_worker2_enabled= false;}
 	worker2_waiting_time+= get_elapsed_time(start_time);
+	trace(2, TRACE_WAIT, 'A', batch_id, start_time);
+	if (EXISTENCE && existence_found) {
+		// existence confirmed: cancelled (end-signal, no further batches)
+		{lock_guard<mutex> lk(mx2); cv2_scheduler_enabled= true;} cv2.notify_one();
+		cout << "worker2 cancelled on A \n"; fflush(stdout);
+		return;
+	}
 	start_time= start_timer();
 
 		//p cout << "worker2 processes container A \n"; fflush(stdout);
@@ -649,7 +1671,9 @@ void worker2_thread()
 		// ***********************************************************
 		// worker2 produces/processes the current batch in container A
 		// ***********************************************************
-		hash_batch(buf_ctr_A, batch_size, com_ctr_A, div_ctr_A);
+		if (STREAMING) batch_size= size_ctr_A;
+		dedup_ctr_A= (dedup_enabled && batch_id > 1 && batch_size > 0) ? dedup_lookup(buf_ctr_A, batch_size, dedup_key_ctr_A) : -2;
+		if (HASH_STAGE && dedup_ctr_A < 0) hash_batch(buf_ctr_A, batch_size, com_ctr_A, div_ctr_A);
 		// this_thread::sleep_for(chrono::milliseconds(100));
 		//p cout << "worker2 completed container A \n"; fflush(stdout);
 		//p cout << "1A "; fflush(stdout);
@@ -660,7 +1684,9 @@ void worker2_thread()
 		{lock_guard<mutex> lk(mx2); cv2_scheduler_enabled= true;} cv2.notify_one();
 
 	worker2_process_time+= get_elapsed_time(start_time);
-	if (batch_id == batch_count) {
+	trace(2, TRACE_PROCESS, 'A', batch_id, start_time);
+	if (HASH_STAGE) progress_add(progress_hashed, batch_size);
+	if (batch_id == (STREAMING ? stream_batch_count.load() : batch_count)) {
 		// the current batch was the last one
 		cout << "worker2 terminates on A \n"; fflush(stdout);
 		return;
@@ -679,6 +1705,13 @@ void worker2_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_worker2_enabled;}); cv2_worker2_enabled= false;}
 	worker2_waiting_time+= get_elapsed_time(start_time);
+	trace(2, TRACE_WAIT, 'B', batch_id, start_time);
+	if (EXISTENCE && existence_found) {
+		// existence confirmed: cancelled (end-signal, no further batches)
+		{lock_guard<mutex> lk(mx2); cv2_scheduler_enabled= true;} cv2.notify_one();
+		cout << "worker2 cancelled on B \n"; fflush(stdout);
+		return;
+	}
 	start_time= start_timer();
 
 		//p cout << "worker2 processes container B \n"; fflush(stdout);
@@ -687,7 +1720,9 @@ void worker2_thread()
 		// ***********************************************************
 		// worker2 produces/processes the current batch in container B
 		// ***********************************************************
-		hash_batch(buf_ctr_B, batch_size, com_ctr_B, div_ctr_B);
+		if (STREAMING) batch_size= size_ctr_B;
+		dedup_ctr_B= (dedup_enabled && batch_id > 1 && batch_size > 0) ? dedup_lookup(buf_ctr_B, batch_size, dedup_key_ctr_B) : -2;
+		if (HASH_STAGE && dedup_ctr_B < 0) hash_batch(buf_ctr_B, batch_size, com_ctr_B, div_ctr_B);
 		// this_thread::sleep_for(chrono::milliseconds(100));
 		//p cout << "worker2 completed container B \n"; fflush(stdout);
 		//p cout << "1B "; fflush(stdout);
@@ -698,7 +1733,9 @@ void worker2_thread()
 		{lock_guard<mutex> lk(mx2); cv2_scheduler_enabled= true;} cv2.notify_one();
 
 	worker2_process_time+= get_elapsed_time(start_time);
-	if (batch_id == batch_count) {
+	trace(2, TRACE_PROCESS, 'B', batch_id, start_time);
+	if (HASH_STAGE) progress_add(progress_hashed, batch_size);
+	if (batch_id == (STREAMING ? stream_batch_count.load() : batch_count)) {
 		// the current batch was the last one
 		cout << "worker2 terminates on B \n"; fflush(stdout);
 		return;
@@ -717,6 +1754,13 @@ void worker2_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_worker2_enabled;}); cv2_worker2_enabled= false;}
 	worker2_waiting_time+= get_elapsed_time(start_time);
+	trace(2, TRACE_WAIT, 'C', batch_id, start_time);
+	if (EXISTENCE && existence_found) {
+		// existence confirmed: cancelled (end-signal, no further batches)
+		{lock_guard<mutex> lk(mx2); cv2_scheduler_enabled= true;} cv2.notify_one();
+		cout << "worker2 cancelled on C \n"; fflush(stdout);
+		return;
+	}
 	start_time= start_timer();
 
 		//p cout << "worker2 processes container C \n"; fflush(stdout);
@@ -725,7 +1769,9 @@ void worker2_thread()
 		// ***********************************************************
 		// worker2 produces/processes the current batch in container C
 		// ***********************************************************
-		hash_batch(buf_ctr_C, batch_size, com_ctr_C, div_ctr_C);
+		if (STREAMING) batch_size= size_ctr_C;
+		dedup_ctr_C= (dedup_enabled && batch_id > 1 && batch_size > 0) ? dedup_lookup(buf_ctr_C, batch_size, dedup_key_ctr_C) : -2;
+		if (HASH_STAGE && dedup_ctr_C < 0) hash_batch(buf_ctr_C, batch_size, com_ctr_C, div_ctr_C);
 		// this_thread::sleep_for(chrono::milliseconds(100));
 		//p cout << "worker2 completed container C \n"; fflush(stdout);
 		//p cout << "1C "; fflush(stdout);
@@ -736,7 +1782,9 @@ void worker2_thread()
 		{lock_guard<mutex> lk(mx2); cv2_scheduler_enabled= true;} cv2.notify_one();
 
 	worker2_process_time+= get_elapsed_time(start_time);
-  if (batch_id == batch_count) {
+	trace(2, TRACE_PROCESS, 'C', batch_id, start_time);
+	if (HASH_STAGE) progress_add(progress_hashed, batch_size);
+  if (batch_id == (STREAMING ? stream_batch_count.load() : batch_count)) {
 	  // the current batch was the last one
 	  cout << "worker2 terminates on C \n"; fflush(stdout);
 	  return;
@@ -753,7 +1801,7 @@ void worker2_thread()
 
 void worker3_thread()
 {
-	SetThreadAffinityMask(GetCurrentThread(), 8ULL);
+	SetThreadAffinityMask(GetCurrentThread(), AFFINITY_PROBE);
 
 	Time start_time;			// start of time measurement
 	uint32_t batch_id;			// current batch
@@ -766,6 +1814,7 @@ void worker3_thread()
 	last_batch_size= N - (batch_count * BATCH_SIZE);
 	if (last_batch_size > 0) batch_count++;
 	else last_batch_size= BATCH_SIZE;
+	if (STREAMING) batch_count= UINT32_MAX;	// streaming: the batch size is taken from the container
 	if (batch_count == 1) {
 		// the first batch is also the last one
 		batch_size= last_batch_size;
@@ -784,6 +1833,13 @@ void worker3_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_worker3_enabled;}); cv3_worker3_enabled= false;}
 	worker3_waiting_time+= get_elapsed_time(start_time);
+	trace(3, TRACE_WAIT, 'A', batch_id, start_time);
+	if (EXISTENCE && existence_found) {
+		// existence confirmed: cancelled (end-signal, no further batches)
+		{lock_guard<mutex> lk(mx3); cv3_scheduler_enabled= true;} cv3.notify_one();
+		cout << "worker3 cancelled on A \n"; fflush(stdout);
+		return;
+	}
 	start_time= start_timer();
 
 		//p cout << "worker3 processes container A \n"; fflush(stdout);
@@ -792,13 +1848,20 @@ void worker3_thread()
 		// ***********************************************************
 		// worker3 produces/processes the current batch in container A
 		// ***********************************************************
+		if (STREAMING) batch_size= size_ctr_A;
 		if (skip_first_carry) {
-			// skip first carry (carry of the first batch)
-			check_batch(batch_size - LC, com_ctr_A + LC, div_ctr_A + LC);
+			// skip first carry (carry of the first batch, streaming: the first batch holds at least LC bytes)
+			sink_batch(min((uint32_t)LC, batch_size), batch_size, com_ctr_A, div_ctr_A);
 			skip_first_carry= false;
+		} else if (dedup_ctr_A >= 0) {
+			// cached chunk: replay its hit runs
+			dedup_replay(dedup_ctr_A, batch_size);
 		} else {
-			check_batch(batch_size, com_ctr_A, div_ctr_A);
+			sink_batch(0, batch_size, com_ctr_A, div_ctr_A);
+			if (dedup_ctr_A == -1) dedup_record(dedup_key_ctr_A, batch_size);
 		}
+		if (EXISTENCE && !existence_found) existence_check();
+		if (STREAMING && batch_size > 0) batch_latency.push_back(get_elapsed_time(arrival_ctr_A));
 		// this_thread::sleep_for(chrono::milliseconds(300));
 		//p cout << "worker3 completed container A \n"; fflush(stdout);
 		//p cout << "3A "; fflush(stdout);
@@ -809,7 +1872,10 @@ void worker3_thread()
 		{lock_guard<mutex> lk(mx3); cv3_scheduler_enabled= true;} cv3.notify_one();
 
 	worker3_process_time+= get_elapsed_time(start_time);
-	if (batch_id == batch_count) {
+	trace(3, TRACE_PROCESS, 'A', batch_id, start_time);
+	progress_probes.store(probe_count, memory_order_relaxed);
+	progress_residue.store(test_runs.residue, memory_order_relaxed);
+	if (batch_id == (STREAMING ? stream_batch_count.load() : batch_count)) {
 		// the current batch was the last one
 		cout << "worker3 terminates on A \n"; fflush(stdout);
 		return;
@@ -828,6 +1894,13 @@ void worker3_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_worker3_enabled;}); cv3_worker3_enabled= false;}
 	worker3_waiting_time+= get_elapsed_time(start_time);
+	trace(3, TRACE_WAIT, 'B', batch_id, start_time);
+	if (EXISTENCE && existence_found) {
+		// existence confirmed: cancelled (end-signal, no further batches)
+		{lock_guard<mutex> lk(mx3); cv3_scheduler_enabled= true;} cv3.notify_one();
+		cout << "worker3 cancelled on B \n"; fflush(stdout);
+		return;
+	}
 	start_time= start_timer();
 
 		//p cout << "worker3 processes container B \n"; fflush(stdout);
@@ -836,7 +1909,16 @@ void worker3_thread()
 		// ***********************************************************
 		// worker3 produces/processes the current batch in container B
 		// ***********************************************************
-		check_batch(batch_size, com_ctr_B, div_ctr_B);
+		if (STREAMING) batch_size= size_ctr_B;
+		if (dedup_ctr_B >= 0) {
+			// cached chunk: replay its hit runs
+			dedup_replay(dedup_ctr_B, batch_size);
+		} else {
+			sink_batch(0, batch_size, com_ctr_B, div_ctr_B);
+			if (dedup_ctr_B == -1) dedup_record(dedup_key_ctr_B, batch_size);
+		}
+		if (EXISTENCE && !existence_found) existence_check();
+		if (STREAMING && batch_size > 0) batch_latency.push_back(get_elapsed_time(arrival_ctr_B));
 		// this_thread::sleep_for(chrono::milliseconds(300));
 		//p cout << "worker3 completed container B \n"; fflush(stdout);
 		//p cout << "3B "; fflush(stdout);
@@ -847,7 +1929,10 @@ void worker3_thread()
 		{lock_guard<mutex> lk(mx3); cv3_scheduler_enabled= true;} cv3.notify_one();
 
 	worker3_process_time+= get_elapsed_time(start_time);
-	if (batch_id == batch_count) {
+	trace(3, TRACE_PROCESS, 'B', batch_id, start_time);
+	progress_probes.store(probe_count, memory_order_relaxed);
+	progress_residue.store(test_runs.residue, memory_order_relaxed);
+	if (batch_id == (STREAMING ? stream_batch_count.load() : batch_count)) {
 		// the current batch was the last one
 		cout << "worker3 terminates on B \n"; fflush(stdout);
 		return;
@@ -866,6 +1951,13 @@ void worker3_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_worker3_enabled;}); cv3_worker3_enabled= false;}
 	worker3_waiting_time+= get_elapsed_time(start_time);
+	trace(3, TRACE_WAIT, 'C', batch_id, start_time);
+	if (EXISTENCE && existence_found) {
+		// existence confirmed: cancelled (end-signal, no further batches)
+		{lock_guard<mutex> lk(mx3); cv3_scheduler_enabled= true;} cv3.notify_one();
+		cout << "worker3 cancelled on C \n"; fflush(stdout);
+		return;
+	}
 	start_time= start_timer();
 
 		//p cout << "worker3 processes container C \n"; fflush(stdout);
@@ -874,7 +1966,16 @@ void worker3_thread()
 		// ***********************************************************
 		// worker3 produces/processes the current batch in container C
 		// ***********************************************************
-		check_batch(batch_size, com_ctr_C, div_ctr_C);
+		if (STREAMING) batch_size= size_ctr_C;
+		if (dedup_ctr_C >= 0) {
+			// cached chunk: replay its hit runs
+			dedup_replay(dedup_ctr_C, batch_size);
+		} else {
+			sink_batch(0, batch_size, com_ctr_C, div_ctr_C);
+			if (dedup_ctr_C == -1) dedup_record(dedup_key_ctr_C, batch_size);
+		}
+		if (EXISTENCE && !existence_found) existence_check();
+		if (STREAMING && batch_size > 0) batch_latency.push_back(get_elapsed_time(arrival_ctr_C));
 		// this_thread::sleep_for(chrono::milliseconds(300));
 		//p cout << "worker3 completed container C \n"; fflush(stdout);
 		//p cout << "3C "; fflush(stdout);
@@ -885,7 +1986,10 @@ void worker3_thread()
 		{lock_guard<mutex> lk(mx3); cv3_scheduler_enabled= true;} cv3.notify_one();
 
 	worker3_process_time+= get_elapsed_time(start_time);
-	if (batch_id == batch_count) {
+	trace(3, TRACE_PROCESS, 'C', batch_id, start_time);
+	progress_probes.store(probe_count, memory_order_relaxed);
+	progress_residue.store(test_runs.residue, memory_order_relaxed);
+	if (batch_id == (STREAMING ? stream_batch_count.load() : batch_count)) {
 		// the current batch was the last one
 		cout << "worker3 terminates on C \n"; fflush(stdout);
 		return;
@@ -902,48 +2006,195 @@ void worker3_thread()
 
 // ****************************************************************************************************************************
 
-inline void update_div_hashes(uint8_t hash[], uint8_t hash1[], const uint8_t s[]) {
-	uint64_t t= 256*M_DIV + s[L];
-	for (uint8_t id= 0; id < DV; id++) {
-		hash1[id]= hash[id]= (t  +  hash[id] * B_DIV[id]  -  C_DIV[id] * s[0]) % M_DIV;
-	}
-}
-
-void hash_batch(
+// position-parallel hashing
+// -------------------------
+// Because L is short, each fingerprint is evaluated directly as an L-term dot product
+// of the shingle bytes with the powers of the base, reduced only once (lazy reduction):
+//   com_hash[j]=       (s[j]*P_COM[0]     + ... + s[j+L-1]*P_COM[L-1])     % M_COM
+//   div_hash[id][j]=   (s[j]*P_DIV[id][0] + ... + s[j+L-1]*P_DIV[id][L-1]) % M_DIV
+// The positions j are independent (no loop carried dependency) and the result is
+// bit-identical to the rolling recurrence.
+// AVX2: common hashes      4 positions per register (exact in double precision: < 2^53)
+//       diversified hashes 8 positions per register and cofilter lane (exact in float: < 2^24)
+
+void rk_hash_batch(
 	uint8_t  s[], 			// input : current string buffer
 	uint32_t hash_count, 	// input : number of hashes
-	uint64_t com_hash[], 	// output: batch of (hash_count)      common hashes
-	uint8_t  div_hash[]) 	// output: batch of (hash_count * DV) diversified hashes
+	com_t com_hash[], 	// output: batch of (hash_count) common hashes
+	uint8_t  div_hash[][BATCH_SIZE]) // output: DV lanes of (hash_count) diversified hashes
 {
 	// produce batch of hashes (common & diversified)
 	// for the shingles in the current input buffer s
+	uint32_t j_com= 0;		// first common hash left to the scalar loop
+	uint32_t j_div= 0;		// first diversified hash left to the scalar loop
 
-	// compute diversified hashes
+#ifdef __AVX2__
+#if !WIDE_MAP
+	// compute common hashes (4 positions in parallel)
+	// ---------------------
+	const __m256d m_com= _mm256_set1_pd((double)M_COM);
+	const __m256d m_inv= _mm256_set1_pd(1.0 / (double)M_COM);
+	const __m256d zero=  _mm256_setzero_pd();
+	__m256d p_com[L];
+	for (uint32_t k= 0; k < L; k++) p_com[k]= _mm256_set1_pd((double)P_COM[k]);
+	for (; j_com + 4 <= hash_count; j_com+= 4) {
+		__m256d h= zero;
+		for (uint32_t k= 0; k < L; k++) {
+			uint32_t b;
+			memcpy(&b, s + j_com + k, 4);
+			__m256d v= _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(b)));
+			h= _mm256_add_pd(h, _mm256_mul_pd(v, p_com[k]));
+		}
+		// lazy reduction: the quotient is exact or off by one
+		__m256d q= _mm256_round_pd(_mm256_mul_pd(h, m_inv), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+		__m256d r= _mm256_sub_pd(h, _mm256_mul_pd(q, m_com));
+		r= _mm256_add_pd(r, _mm256_and_pd(_mm256_cmp_pd(r, zero, _CMP_LT_OQ), m_com));
+		r= _mm256_sub_pd(r, _mm256_and_pd(_mm256_cmp_pd(r, m_com, _CMP_GE_OQ), m_com));
+		_mm_storeu_si128((__m128i *)&com_hash[j_com], _mm256_cvttpd_epi32(r));
+	}
+#endif
+
+	// compute diversified hashes (8 positions in parallel)
 	// --------------------------
-	// compute the hashes of the first, leftmost shingles
+	// byte pairs (s[j+k], s[j+k+1]) times coefficient pairs: _mm256_madd_epi16
+	const __m256  d_inv= _mm256_set1_ps(1.0f / (float)M_DIV);
+	const __m256i d_mod= _mm256_set1_epi32((int)M_DIV);
+	const __m256i d_max= _mm256_set1_epi32((int)M_DIV - 1);
+	// dword order after packing: cofilter (0,1,2,3 | 4,5,6,7) x positions (0-3 | 4-7) -> 8 positions per cofilter
+	const __m256i d_ord= _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	__m256i p_div[DV][(L+1)/2];
 	for (uint8_t id= 0; id < DV; id++) {
-		div_hash[id]= 0;
-		for (uint32_t j= 0; j < L; j++) {
-			div_hash[id]= (div_hash[id] * B_DIV[id] + s[j]) % M_DIV;
+		for (uint32_t k= 0; k < L; k+= 2) {
+			uint32_t c= P_DIV[id][k] | ((k+1 < L) ? P_DIV[id][k+1] << 16 : 0);
+			p_div[id][k/2]= _mm256_set1_epi32((int)c);
 		}
-		div_hash[DV+id]= div_hash[id];
 	}
-	// compute the hashes of the following shingles (rolling forward)
-	// note: j= 1!
-	for (uint32_t j= 1; j < hash_count; j++) {
-		update_div_hashes(&div_hash[j*DV], &div_hash[(j+1)*DV], s+j-1);
+	for (; j_div + 8 <= hash_count; j_div+= 8) {
+		__m256i w[(L+1)/2];
+		for (uint32_t k= 0; k < L; k+= 2) {
+			uint64_t b;
+			memcpy(&b, s + j_div + k, 8);
+			w[k/2]= _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(b));
+			if (k+1 < L) {
+				memcpy(&b, s + j_div + k + 1, 8);
+				w[k/2]= _mm256_or_si256(w[k/2], _mm256_slli_epi32(_mm256_cvtepu8_epi32(_mm_cvtsi64_si128(b)), 16));
+			}
+		}
+		__m256i r[DV];
+		for (uint8_t id= 0; id < DV; id++) {
+			__m256i h= _mm256_madd_epi16(w[0], p_div[id][0]);
+			for (uint32_t k= 1; k < (L+1)/2; k++) {
+				h= _mm256_add_epi32(h, _mm256_madd_epi16(w[k], p_div[id][k]));
+			}
+			// lazy reduction: the quotient is exact or one too small
+			__m256i q= _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(h), d_inv));
+			r[id]= _mm256_sub_epi32(h, _mm256_mullo_epi32(q, d_mod));
+			r[id]= _mm256_sub_epi32(r[id], _mm256_and_si256(_mm256_cmpgt_epi32(r[id], d_max), d_mod));
+		}
+		// pack to bytes: 8 positions of each cofilter lane
+		for (uint8_t id= 0; id < DV; id+= 4) {
+			__m256i x= _mm256_permutevar8x32_epi32(_mm256_packus_epi16(
+					_mm256_packus_epi32(r[id], r[id+1]), _mm256_packus_epi32(r[id+2], r[id+3])), d_ord);
+			__m128i lo= _mm256_castsi256_si128(x);
+			__m128i hi= _mm256_extracti128_si256(x, 1);
+			_mm_storel_epi64((__m128i *)&div_hash[id  ][j_div], lo);
+			_mm_storel_epi64((__m128i *)&div_hash[id+1][j_div], _mm_unpackhi_epi64(lo, lo));
+			_mm_storel_epi64((__m128i *)&div_hash[id+2][j_div], hi);
+			_mm_storel_epi64((__m128i *)&div_hash[id+3][j_div], _mm_unpackhi_epi64(hi, hi));
+		}
 	}
+#endif
 
-	// compute common hashes
+	// compute common hashes (remaining positions)
 	// ---------------------
-	// compute the hashes of the first, leftmost shingle
-	com_hash[0]= 0;
-	for (uint32_t j= 0; j < L; j++) {
-		com_hash[0]= (com_hash[0] * B_COM + s[j]) % M_COM;
+	for (uint32_t j= j_com; j < hash_count; j++) {
+		uint64_t h= 0;
+		for (uint32_t k= 0; k < L; k++) h+= s[j+k] * P_COM[k];
+		com_hash[j]= h % M_COM;
 	}
-	// compute the hashes of the following shingles in the buffer
+
+	// compute diversified hashes (remaining positions)
+	// --------------------------
+	for (uint8_t id= 0; id < DV; id++) {
+		for (uint32_t j= j_div; j < hash_count; j++) {
+			uint32_t h= 0;
+			for (uint32_t k= 0; k < L; k++) h+= s[j+k] * (uint32_t)P_DIV[id][k];
+			div_hash[id][j]= h % M_DIV;
+		}
+	}
+}
+
+// CRC32C fingerprints
+// -------------------
+// per shingle: c0= crc(w), c1= crc(w * CRC_MIX) over the L-byte window w (8 bytes per step)
+//   com_hash[j]=       (c0 * M_COM) >> 32
+//   div_hash[id][j]=   ((((c1 * A_DIV[id]) mod 2^32) >> 16) * M_DIV) >> 16
+// The hardware instruction (SSE4.2) hashes 8 bytes per cycle, no divisions are left.
+
+inline uint64_t load_window(const uint8_t s[], uint32_t len) {
+	// little endian word of the len (<= 8) bytes at s, without reading beyond s[len-1]
+	// (composed from aligned-size loads: a single narrow memcpy would stall on store forwarding)
+	uint64_t w= 0;
+	uint32_t k= 0;
+	if (len == 8) {memcpy(&w, s, 8); return(w);}
+	if (len - k >= 4) {uint32_t v; memcpy(&v, s + k, 4); w|= (uint64_t)v << (8*k); k+= 4;}
+	if (len - k >= 2) {uint16_t v; memcpy(&v, s + k, 2); w|= (uint64_t)v << (8*k); k+= 2;}
+	if (len - k >= 1) {w|= (uint64_t)s[k] << (8*k);}
+	return(w);
+}
+
+inline uint32_t crc32c_u64(uint32_t crc, uint64_t w) {
+#ifdef __SSE4_2__
+	return (uint32_t)_mm_crc32_u64(crc, w);
+#else
+	for (int k= 0; k < 8; k++) {
+		crc= CRC_TABLE[(crc ^ w) & 0xFF] ^ (crc >> 8);
+		w>>= 8;
+	}
+	return crc;
+#endif
+}
+
+void crc_hash_batch(
+	uint8_t  s[], 			// input : current string buffer
+	uint32_t hash_count, 	// input : number of hashes
+	com_t com_hash[], 	// output: batch of (hash_count) common hashes
+	uint8_t  div_hash[][BATCH_SIZE]) // output: DV lanes of (hash_count) diversified hashes
+{
 	for (uint32_t j= 0; j < hash_count; j++) {
-		com_hash[j+1]= ((com_hash[j] + M_COM) * B_COM   -  C_COM * s[j]   +   s[j+L]) % M_COM;
+		uint32_t c0= CRC_SEED;
+		uint32_t c1= CRC_SEED;
+		for (uint32_t k= 0; k < L; k+= 8) {
+			uint64_t w= load_window(s + j + k, (L - k < 8) ? L - k : 8);
+			c0= crc32c_u64(c0, w);
+			c1= crc32c_u64(c1, w * CRC_MIX);
+		}
+		com_hash[j]= ((unsigned __int128)c0 * M_COM) >> 32;
+		for (uint8_t id= 0; id < DV; id++) {
+			div_hash[id][j]= (((c1 * A_DIV[id]) >> 16) * (uint32_t)M_DIV) >> 16;
+		}
+	}
+}
+
+void hash_batch(
+	uint8_t  s[], 			// input : current string buffer
+	uint32_t hash_count, 	// input : number of hashes
+	com_t com_hash[], 	// output: batch of (hash_count) common hashes
+	uint8_t  div_hash[][BATCH_SIZE]) // output: DV lanes of (hash_count) diversified hashes
+{
+	// fingerprint family of the map
+	if (fp_family == FP_CRC32C) crc_hash_batch(s, hash_count, com_hash, div_hash);
+	else rk_hash_batch(s, hash_count, com_hash, div_hash);
+	if (m_map < M_COM) {
+		// folded (sparse) or reduced map: com % m_map by multiplication (Lemire's fastmod, 32 bit operands)
+#if WIDE_MAP
+		for (uint32_t j= 0; j < hash_count; j++) com_hash[j]%= m_map;
+#else
+		uint64_t c= UINT64_MAX / m_map + 1;
+		for (uint32_t j= 0; j < hash_count; j++) {
+			com_hash[j]= ((__uint128_t)(c * com_hash[j]) * m_map) >> 64;
+		}
+#endif
 	}
 }
 
@@ -958,38 +2209,1103 @@ inline uint8_t check_hash(		// returns w: the accumulated mask
 	}
 	return(w);
 }
+inline bool probe_shingle(		// returns true: the shingle is in the filter (Bloom, xor, counting map)
+		com_t com,
+		const uint8_t d[DV])
+{
+	if (backend == BACKEND_COUNTING) {
+		// hit: the counters of all DV cofilters are nonzero
+		const uint32_t *counters= (const uint32_t *)map;
+		for (uint8_t id= 0; id < DV; id++) {
+			if (((counters[com + d[id]] >> (4*id)) & 0xF) == 0) return(false);
+		}
+		return(true);
+	}
+	uint64_t key= shingle_key(com, d);
+	if (backend == BACKEND_BLOOM) {
+		uint64_t mask= bloom_mask(key);
+		return((((uint64_t *)map)[bloom_block(key, map_size / 8)] & mask) == mask);
+	}
+	uint64_t h= xor_hash(key, filter_seed);
+	uint64_t segment= map_size / 3;
+	return((xor_fingerprint(h) ^ map[xor_slot(h, 0, segment)]
+			^ map[xor_slot(h, 1, segment)] ^ map[xor_slot(h, 2, segment)]) == 0);
+}
+inline bool probe_cached(		// returns true: the shingle is in the filter (Bloom, xor, counting map), verdict cached
+		com_t com,
+		uint8_t div_hash[][BATCH_SIZE],
+		uint32_t j)
+{
+	uint8_t d[DV];
+	uint64_t div= 0;
+	for (uint8_t id= 0; id < DV; id++) div|= (uint64_t)div_hash[id][j] << (8*id);
+	probe_cache_slot &slot= probe_cache[((com ^ div) * CRC_MIX) >> (64 - PROBE_CACHE_BITS)];
+	if ((slot.com & ~(1ULL << 63)) == com && slot.div == div) {
+		probe_cache_hits++;
+		return(slot.com >> 63);
+	}
+	for (uint8_t id= 0; id < DV; id++) d[id]= div_hash[id][j];
+	bool hit= probe_shingle(com, d);
+	slot.com= com | ((uint64_t)hit << 63);
+	slot.div= div;
+	return(hit);
+}
+// vectorized probe
+// ----------------
+// 8 (AVX2) or 16 (AVX-512) shingles per step: for each cofilter id the addresses
+// com_hash[j] + div_hash[id][j] of the shingles are one vector add of two SoA lanes,
+// the map bytes are fetched by one gather instruction (vpgatherdd, 4 bytes per address)
+// and bit id is accumulated. The DV gathers of a step are independent, which keeps
+// DV * 8 (16) map reads in flight. A single compare with zero and a movemask
+// then yield one hit bit per shingle (hit: the shingle is marked in all DV cofilters).
+// A block load of the map is of no use here: the offsets of a shingle span M_DIV= 67 bytes.
+#if defined(__AVX2__) && !WIDE_MAP
+inline uint32_t probe_8(		// returns the hit mask of the shingles j .. j+7
+		const com_t com_hash[],
+		uint8_t  div_hash[][BATCH_SIZE],
+		uint32_t j)
+{
+	__m256i com= _mm256_loadu_si256((const __m256i *)&com_hash[j]);
+	__m256i acc= _mm256_setzero_si256();
+	for (uint8_t id= 0; id < DV; id++) {
+		__m256i div= _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)&div_hash[id][j]));
+		__m256i w=   _mm256_i32gather_epi32((const int *)map, _mm256_add_epi32(com, div), 1);
+		acc= _mm256_or_si256(acc, _mm256_and_si256(w, _mm256_set1_epi32(1 << id)));
+	}
+	return(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(acc, _mm256_setzero_si256()))));
+}
+#endif
+#if defined(__AVX512F__) && !WIDE_MAP
+inline uint32_t probe_16(		// returns the hit mask of the shingles j .. j+15
+		const com_t com_hash[],
+		uint8_t  div_hash[][BATCH_SIZE],
+		uint32_t j)
+{
+	__m512i com= _mm512_loadu_si512((const void *)&com_hash[j]);
+	__m512i acc= _mm512_setzero_si512();
+	for (uint8_t id= 0; id < DV; id++) {
+		__m512i div= _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)&div_hash[id][j]));
+		__m512i w=   _mm512_i32gather_epi32(_mm512_add_epi32(com, div), (const void *)map, 1);
+		acc= _mm512_or_si512(acc, _mm512_and_si512(w, _mm512_set1_epi32(1 << id)));
+	}
+	return(_mm512_cmpeq_epi32_mask(acc, _mm512_setzero_si512()));
+}
+#endif
+
+void sink_batch(
+	uint32_t j0,			// input : first hash
+	uint32_t hash_count,	// input : number of hashes
+	com_t com_hash[],	// input : batch of hash_count common hashes
+	uint8_t  div_hash[][BATCH_SIZE]) // input : DV lanes of hash_count diversified hashes
+{
+	// pipeline endpoint of worker3: probe the map, discard or checksum the hashes
+	if (SINK == SINK_PROBE) {
+		if (cdc_enabled) cdc_check_batch(j0, hash_count, com_hash, div_hash);
+		else check_batch(j0, hash_count, com_hash, div_hash);
+		return;
+	}
+	if (SINK == SINK_CHECKSUM) {
+		uint64_t h= sink_checksum;
+		for (uint32_t j= j0; j < hash_count; j++) {
+			h= (h ^ com_hash[j]) * 0x100000001B3ULL;
+			for (uint8_t id= 0; id < DV; id++) h= (h ^ div_hash[id][j]) * 0x100000001B3ULL;
+		}
+		sink_checksum= h;
+	}
+	test_runs.position+= hash_count - j0;
+}
+
 void check_batch(
+	uint32_t j0,			// input : first hash to check
 	uint32_t hash_count,	// input : number of hashes
-	uint64_t com_hash[],	// input : batch of hash_count common hashes
-	uint8_t  div_hash[])	// input : batch of (hash_count * DV) diversified hashes
+	com_t com_hash[],	// input : batch of hash_count common hashes
+	uint8_t  div_hash[][BATCH_SIZE]) // input : DV lanes of hash_count diversified hashes
 {
 	// uint8_t  map[],		// input : hash map (global)
 	// check current batch of hashes (common + diversity) against the hash map
 
 	uint64_t hash[DV];		// current compound hashes
-	static uint64_t count= 0;
+	uint32_t hits;			// hit mask of the current step (bit k: shingle j+k)
+	uint32_t width;			// number of shingles of the current step
+	uint64_t (&hit_mask)[BATCH_SIZE / 64 + 1]= batch_hit_mask;	// hit mask of the batch (bit i: shingle j0+i)
 
-	for (uint32_t j= 0; j < hash_count; j++) {
-		// if it doesnt help, it doesnt hurt?
-		for (uint64_t i= 0; i < ((M_DIV + 32) / 64); i++) {
-			__builtin_prefetch (&com_hash[j] + i * 64, 0, 3);
+	memset(hit_mask, 0, sizeof(hit_mask));
+
+	if (GENERATIONS > 0 && refresh_ready.load(memory_order_acquire)) {
+		// take over the combined map refreshed by the background thread (between two batches)
+		swap(map, spare_map);
+		refresh_count++;
+		refresh_ready.store(false, memory_order_release);
+	}
+
+	if (sampling == SAMPLE_MINIMIZER) {
+		// probe the window minimizers only, bit i: verdict of the window ending at shingle j0+i
+		static bool verdict= false;		// verdict of the last minimizer
+		uint32_t m;
+		for (uint32_t j= j0; j < hash_count; j++) {
+			if (!push_window(test_window, test_runs.position + j - j0, com_hash[j], div_hash, j, m)) continue;
+			if (test_window.position[m] != test_window.last) {
+				test_window.last= test_window.position[m];
+				if (backend == BACKEND_BITMAP) {
+					for (uint8_t id= 0; id < DV; id++) {
+						hash[id]= test_window.com[m] + test_window.div[m][id];
+					}
+					verdict= (check_hash(hash) == 0);
+				} else {
+					verdict= probe_shingle(test_window.com[m], test_window.div[m]);
+				}
+				probe_count++;
+			}
+			if (verdict) hit_mask[(j - j0) >> 6]|= 1ULL << ((j - j0) & 63);
 		}
+		detect_runs(test_runs, hit_mask, hash_count - j0);
+		return;
+	}
+	probe_count+= hash_count - j0;
 
-		// current aggregated hashes
-		for (uint8_t id= 0; id < DV; id++) {
-			hash[id]= com_hash[j] + div_hash[j*DV + id];
+	if (backend != BACKEND_BITMAP && PROBE_CACHE && probe_cache_bypass == 0) {
+		// repeated fingerprints: verdicts from the probe cache
+		uint64_t hits_before= probe_cache_hits;
+		for (uint32_t j= j0; j < hash_count; j++) {
+			if (probe_cached(com_hash[j], div_hash, j)) hit_mask[(j - j0) >> 6]|= 1ULL << ((j - j0) & 63);
+		}
+		probe_cache_lookups+= hash_count - j0;
+		// adaptive bypass: IID data hardly repeats a fingerprint
+		if (probe_cache_hits - hits_before < PROBE_CACHE_MIN_RATE * (hash_count - j0)) {
+			probe_cache_bypass= probe_cache_backoff;
+			probe_cache_backoff= min(2 * probe_cache_backoff, (uint32_t)PROBE_CACHE_MAX_BYPASS);
+		} else {
+			probe_cache_backoff= 1;
+		}
+		detect_runs(test_runs, hit_mask, hash_count - j0);
+		return;
+	}
+
+	if (backend != BACKEND_BITMAP) {
+		uint8_t d[DV];
+		if (PROBE_CACHE) {
+			probe_cache_bypass--;
+			probe_cache_bypassed+= hash_count - j0;
+		}
+		for (uint32_t j= j0; j < hash_count; j++) {
+			for (uint8_t id= 0; id < DV; id++) d[id]= div_hash[id][j];
+			if (probe_shingle(com_hash[j], d)) hit_mask[(j - j0) >> 6]|= 1ULL << ((j - j0) & 63);
+		}
+		detect_runs(test_runs, hit_mask, hash_count - j0);
+		return;
+	}
+
+	for (uint32_t j= j0; j < hash_count; j+= width) {
+#if defined(__AVX512F__) && !WIDE_MAP
+		if (j + 16 <= hash_count) {
+			hits= probe_16(com_hash, div_hash, j);
+			width= 16;
+		} else
+#endif
+#if defined(__AVX2__) && !WIDE_MAP
+		if (j + 8 <= hash_count) {
+			hits= probe_8(com_hash, div_hash, j);
+			width= 8;
+		} else
+#endif
+		{
+			// current aggregated hashes
+			for (uint8_t id= 0; id < DV; id++) {
+				hash[id]= com_hash[j] + div_hash[id][j];
+			}
+
+			hits= (check_hash(hash) == 0);
+			width= 1;
+		}
+
+		// prefetch the slots of the shingles PREFETCH_DISTANCE ahead (com .. com + M_DIV-1: up to 2 cache lines)
+		for (uint32_t k= j + PREFETCH_DISTANCE; PREFETCH_DISTANCE > 0 && k < j + width + PREFETCH_DISTANCE && k < hash_count; k++) {
+			__builtin_prefetch (&map[com_hash[k]], 0, 3);
+			__builtin_prefetch (&map[com_hash[k] + M_DIV - 1], 0, 3);
+		}
+
+		// insert the hits of the step into the hit mask of the batch
+		uint32_t i= j - j0;
+		hit_mask[i >> 6]|= (uint64_t)hits << (i & 63);
+		if ((i & 63) + width > 64) hit_mask[(i >> 6) + 1]|= (uint64_t)hits >> (64 - (i & 63));
+	}
+
+	detect_runs(test_runs, hit_mask, hash_count - j0);
+}
+
+//	*********************************************************************************************************************************************
+
+inline void close_run(run_state &rs) {
+	// the current run of hits ends
+	if (rs.count + rs.extent > rs.max_count) rs.max_count= rs.count + rs.extent;
+	if (rs.count >= rs.threshold) {
+		if (rs.run_count++ < MAX_RUNS) rs.runs.push_back({rs.start - rs.extent, rs.count + rs.extent});
+	}
+	rs.count= 0;
+}
+
+void detect_runs(
+	run_state &rs,			// in/out: run state (carried across batches)
+	const uint64_t hit_mask[],	// input : hit bits of the batch (zero beyond nbits)
+	uint32_t nbits)			// input : number of shingles
+{
+	// residue: shift-AND cascade over 64 shingles at a time,
+	// bit i of r is set <=> the shingles i-threshold+1 .. i are hits
+	// carry-in: the current run (hits of the previous batch)
+	uint64_t prev= (rs.count >= 64) ? ~0ULL : ((rs.count > 0) ? ~0ULL << (64 - rs.count) : 0);
+	for (uint32_t w= 0; w < (nbits + 63) / 64; w++) {
+		uint64_t x= hit_mask[w];
+		uint64_t r= x;
+		for (uint32_t t= 1; t < rs.threshold; t++) {
+			r&= (x << t) | (prev >> (64 - t));
+		}
+		rs.residue+= __builtin_popcountll(r);
+		prev= x;
+	}
+
+	// survivor runs: run boundaries by counting trailing ones / zeros
+	uint32_t i= 0;
+	while (i < nbits) {
+		uint64_t x= hit_mask[i >> 6] >> (i & 63);
+		uint32_t n;
+		if (x & 1) {
+			// hits: (bits beyond the word are zero)
+			n= (~x == 0) ? 64 : __builtin_ctzll(~x);
+			if (rs.count == 0) rs.start= rs.position + i;
+			rs.count+= n;
+		} else {
+			// misses:
+			if (rs.count > 0) close_run(rs);
+			n= (x == 0) ? 64 - (i & 63) : __builtin_ctzll(x);
+			if (n > nbits - i) n= nbits - i;
+		}
+		i+= n;
+	}
+	rs.position+= nbits;
+}
+
+void finish_runs(run_state &rs) {
+	if (rs.count > 0) close_run(rs);
+}
+
+void scan_region(
+	ifstream &string_input_stream,	// input : master file
+	uint64_t first,					// input : master file offset of the first shingle
+	uint64_t length,				// input : number of shingles
+	uint64_t demo_offset,			// input : master file offset of the "Demo-String" (20 bytes)
+	bool record)					// input : true: record the shingles in the map, false: check them
+{
+	// the region is re-read, shuffled and hashed batch-wise in container A (the workers have terminated)
+	// output (check): test_runs (global), position is set by the caller
+	for (uint64_t offset= 0; offset < length; offset+= BATCH_SIZE) {
+		uint32_t hash_count= (uint32_t)min(length - offset, (uint64_t)BATCH_SIZE);
+		uint64_t begin= first + offset;
+		string_input_stream.seekg(begin, string_input_stream.beg);
+		string_input_stream.read((char *)buf_ctr_A, hash_count + LC);
+		if (hash_count + LC != string_input_stream.gcount()) exit(14);
+		for (uint32_t j= 0; j < hash_count + LC; j++) {
+			buf_ctr_A[j]= shuffle[buf_ctr_A[j]];
+			if (begin + j >= demo_offset && begin + j < demo_offset + 20) buf_ctr_A[j]= 0;
+		}
+		hash_batch(buf_ctr_A, hash_count, com_ctr_A, div_ctr_A);
+		if (record) {
+			for (uint32_t j= 0; j < hash_count; j++) {
+				for (uint8_t id= 0; id < DV; id++) {
+					// ClearBit
+					map[com_ctr_A[j] + div_ctr_A[id][j]] &= ~(1<<id);
+				}
+			}
+		} else {
+			check_batch(0, hash_count, com_ctr_A, div_ctr_A);
+		}
+	}
+}
+
+void refine_runs(
+	const run_state &survivors,			// input : survivor runs of the previous round
+	ifstream &string_input_stream)		// input : master file
+{
+	// output: test_runs (global), survivors of the current round
+	uint64_t demo_offset= ns + (N / BATCH_SIZE / 3) * BATCH_SIZE - 10;	// "Demo-String" (cf. worker1)
+	for (const survivor_run &run : survivors.runs) {
+		test_runs.position= run.start;
+		scan_region(string_input_stream, ns + run.start, run.length, demo_offset, false);
+		finish_runs(test_runs);
+	}
+}
+
+void reduce_reference(
+	ifstream &string_input_stream)		// input : master file
+{
+	// output: reference_runs (global), regions of s that can participate in a match
+	// the survivors of S are recorded in a reduced map (all shingles, current fingerprints),
+	// the reference shingles (bytes 0 .. ns-1 of the master file, cf. scatter) are checked against it
+	uint64_t survivor_count= 0;
+	for (const survivor_run &run : test_runs.runs) survivor_count+= run.length;
+	uint8_t *full_map= map;
+	uint32_t full_sampling= sampling;
+	uint32_t full_backend= backend;
+	uint64_t full_probe_count= probe_count;
+	m_map= max(RED_FACTOR * survivor_count, (uint64_t)BATCH_SIZE);
+	map= alloc_map(m_map + M_DIV + MAP_PAD); if (map == NULL) exit(11);
+	memset(map, 0b11111111, m_map + M_DIV + MAP_PAD);
+	sampling= SAMPLE_ALL;
+	backend= BACKEND_BITMAP;
+	uint64_t demo_offset= ns + (N / BATCH_SIZE / 3) * BATCH_SIZE - 10;	// "Demo-String" in S (cf. worker1)
+	for (const survivor_run &run : test_runs.runs) {
+		scan_region(string_input_stream, ns + run.start, run.length, demo_offset, true);
+	}
+	// filter s
+	run_state survivors= test_runs;
+	test_runs= run_state();
+	demo_offset= (ns / BATCH_SIZE / 2 - 1) * BATCH_SIZE;		// "Demo-String" in s (cf. scatter)
+	scan_region(string_input_stream, 0, ns - LC, demo_offset, false);
+	finish_runs(test_runs);
+	reference_runs= test_runs;
+	test_runs= survivors;
+	// restore
+	free(map);
+	map= full_map;
+	sampling= full_sampling;
+	backend= full_backend;
+	probe_count= full_probe_count;
+}
+
+//	*********************************************************************************************************************************************
+
+// out-of-core gather
+// ------------------
+// a slab of S is hashed batch-wise (container A), each probe (slab offset, common hash,
+// DV diversified hashes) is spilled to the file of its map region (common hash range).
+// The regions of the map are then read one after the other, a region comprises the
+// M_DIV bytes beyond its common hash range, so that the DV probes of a shingle resolve
+// within one region. The hit bits are set at the slab offsets and the hit mask of the
+// slab is scanned in order: sequential I/O only, map memory M_COM / REGIONS + M_DIV.
+struct spill_record {
+	uint32_t index;				// offset of the shingle in the slab
+	com_t    com;				// common hash
+	uint8_t  div[DV];			// diversified hashes
+};
+
+void out_of_core_gather(
+	string map_file_name)		// input : map file (header read by load_hash_map)
+{
+	// output: test_runs (global)
+	const uint64_t region_size= (M_COM + REGIONS - 1) / REGIONS;	// common hashes per region
+	uint64_t demo_offset= ns + (N / BATCH_SIZE / 3) * BATCH_SIZE - 10;	// "Demo-String" (cf. worker1)
+	ifstream string_input_stream(master_string_file_name, ios::in|ios::binary);
+	ifstream map_input_stream(map_file_name, ios::binary);
+	if (!string_input_stream || !map_input_stream) {
+		cerr << "Can't open master or map file!";
+		exit(26);
+	}
+	uint8_t *region= (uint8_t *)malloc(region_size + M_DIV); if (region == NULL) exit(11);
+	vector<uint64_t> hit_mask(SLAB_SIZE / 64 + 1);
+	vector<spill_record> spill_buffer[REGIONS];
+	vector<spill_record> records(SPILL_BUFFER);
+
+	for (uint64_t slab= 0; slab < N; slab+= SLAB_SIZE) {
+		uint32_t slab_count= (uint32_t)min(N - slab, SLAB_SIZE);	// shingles of the slab
+
+		// hash and spill
+		// --------------
+		ofstream spill_stream[REGIONS];
+		for (uint32_t r= 0; r < REGIONS; r++) {
+			spill_stream[r].open(spill_file_name_prefix + to_string(r) + ".txt", ios::binary|ios::trunc);
+			if (!spill_stream[r]) {
+				cerr << "Can't open spill file!";
+				exit(30);
+			}
+			spill_buffer[r].clear();
+		}
+		for (uint32_t offset= 0; offset < slab_count; offset+= BATCH_SIZE) {
+			uint32_t hash_count= min(slab_count - offset, (uint32_t)BATCH_SIZE);
+			uint64_t begin= ns + slab + offset;
+			string_input_stream.seekg(begin, string_input_stream.beg);
+			string_input_stream.read((char *)buf_ctr_A, hash_count + LC);
+			if (hash_count + LC != string_input_stream.gcount()) exit(14);
+			for (uint32_t j= 0; j < hash_count + LC; j++) {
+				buf_ctr_A[j]= shuffle[buf_ctr_A[j]];
+				if (begin + j >= demo_offset && begin + j < demo_offset + 20) buf_ctr_A[j]= 0;
+			}
+			hash_batch(buf_ctr_A, hash_count, com_ctr_A, div_ctr_A);
+			for (uint32_t j= 0; j < hash_count; j++) {
+				uint32_t r= com_ctr_A[j] / region_size;
+				spill_record record;
+				record.index= offset + j;
+				record.com= com_ctr_A[j];
+				for (uint8_t id= 0; id < DV; id++) record.div[id]= div_ctr_A[id][j];
+				spill_buffer[r].push_back(record);
+				if (spill_buffer[r].size() == SPILL_BUFFER) {
+					spill_stream[r].write((char *)spill_buffer[r].data(), SPILL_BUFFER * sizeof(spill_record));
+					spill_buffer[r].clear();
+				}
+			}
+		}
+		for (uint32_t r= 0; r < REGIONS; r++) {
+			spill_stream[r].write((char *)spill_buffer[r].data(), spill_buffer[r].size() * sizeof(spill_record));
+			spill_stream[r].close();
 		}
 
-		if (check_hash(hash) == 0) count++;
-		else count= 0;
+		// stream the map region by region and resolve the probes
+		// -------------------------------------------------------
+		memset(hit_mask.data(), 0, hit_mask.size() * sizeof(uint64_t));
+		for (uint32_t r= 0; r < REGIONS; r++) {
+			uint64_t first= r * region_size;
+			if (first >= M_COM) break;
+			uint64_t length= min(region_size, (uint64_t)(M_COM - first)) + M_DIV;
+			map_input_stream.seekg(map_offset + first, map_input_stream.beg);
+			map_input_stream.read((char *)region, length);
+			if (length != (uint64_t)map_input_stream.gcount()) exit(27);
+			ifstream spill_input_stream(spill_file_name_prefix + to_string(r) + ".txt", ios::binary);
+			while (true) {
+				spill_input_stream.read((char *)records.data(), SPILL_BUFFER * sizeof(spill_record));
+				uint64_t record_count= spill_input_stream.gcount() / sizeof(spill_record);
+				if (record_count == 0) break;
+				for (uint64_t k= 0; k < record_count; k++) {
+					const spill_record &record= records[k];
+					uint8_t w= 0;
+					for (uint8_t id= 0; id < DV; id++) {
+						w |= region[record.com - first + record.div[id]] & (1<<id);
+					}
+					if (w == 0) hit_mask[record.index >> 6]|= 1ULL << (record.index & 63);
+				}
+			}
+			spill_input_stream.close();
+			remove((spill_file_name_prefix + to_string(r) + ".txt").c_str());
+		}
 
-		if (count > LP - L) residue++;
-		if (count > max_count) max_count= count;
+		// survivors of the slab (in order)
+		// --------------------------------
+		detect_runs(test_runs, hit_mask.data(), slab_count);
+		probe_count+= slab_count;
+		printf("slab %llu : %u shingles, %llu residue \n", slab / SLAB_SIZE + 1, slab_count, test_runs.residue);
+		fflush(stdout);
 	}
+	free(region);
 }
 
 //	*********************************************************************************************************************************************
 
+uint64_t write_regions(
+	const run_state &rs,		// input : runs (offsets of shingles in the string)
+	uint64_t base,				// input : master file offset of the string
+	uint64_t size,				// input : length of the string [bytes]
+	string file_name)			// input : output file name (without ".txt"), index: file_name + "_index.txt"
+{
+	// merge the byte ranges of the runs, padded by L-1 on both sides
+	vector<survivor_run> regions;	// byte ranges: start, length
+	for (const survivor_run &run : rs.runs) {
+		uint64_t begin= (run.start > LC) ? run.start - LC : 0;
+		uint64_t end=   min(run.start + run.length + 2*LC, size);
+		if (!regions.empty() && begin <= regions.back().start + regions.back().length) {
+			regions.back().length= max(regions.back().start + regions.back().length, end) - regions.back().start;
+		} else {
+			regions.push_back({begin, end - begin});
+		}
+	}
+	if (rs.run_count > MAX_RUNS) printf("reduced problem incomplete: more than %llu runs \n", MAX_RUNS);
+
+	// index: one line per region
+	ofstream index_stream(file_name + "_index.txt");
+	if (!index_stream) {
+		cerr << "Can't open index output file!";
+		exit(30);
+	}
+	index_stream << "# output offset, string offset, length [bytes]\n";
+	uint64_t output_offset= 0;
+	for (const survivor_run &region : regions) {
+		index_stream << output_offset << " " << region.start << " " << region.length << "\n";
+		output_offset+= region.length;
+	}
+	index_stream.close();
+
+	// regions: copied from the master file (original bytes, the "Demo-String" exists in memory only)
+#ifdef __linux__
+	// zero-copy (copy_file_range), buffered copy if not supported
+	int fd_in= open(master_string_file_name.c_str(), O_RDONLY);
+	int fd_out= open((file_name + ".txt").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd_in < 0 || fd_out < 0) {
+		cerr << "Can't open reduced output file!";
+		exit(30);
+	}
+	vector<uint8_t> buffer;
+	for (const survivor_run &region : regions) {
+		loff_t offset= base + region.start;
+		uint64_t remaining= region.length;
+		while (remaining > 0) {
+			ssize_t k= buffer.empty() ? copy_file_range(fd_in, &offset, fd_out, NULL, remaining, 0) : -1;
+			if (k < 0) {
+				if (buffer.empty()) buffer.resize(COPY_SIZE);
+				k= pread(fd_in, buffer.data(), min(remaining, (uint64_t)COPY_SIZE), offset);
+				if (k <= 0 || write(fd_out, buffer.data(), k) != k) exit(31);
+				offset+= k;
+			}
+			if (k == 0) exit(31);
+			remaining-= k;
+		}
+	}
+	close(fd_in);
+	close(fd_out);
+#else
+	// buffered copy
+	ifstream string_input_stream(master_string_file_name, ios::in|ios::binary);
+	ofstream reduced_output_stream(file_name + ".txt", ios::binary);
+	if (!string_input_stream || !reduced_output_stream) {
+		cerr << "Can't open reduced output file!";
+		exit(30);
+	}
+	vector<uint8_t> buffer(COPY_SIZE);
+	for (const survivor_run &region : regions) {
+		string_input_stream.seekg(base + region.start, string_input_stream.beg);
+		for (uint64_t remaining= region.length; remaining > 0; ) {
+			uint64_t k= min(remaining, (uint64_t)COPY_SIZE);
+			string_input_stream.read((char *)buffer.data(), k);
+			if (k != (uint64_t)string_input_stream.gcount()) exit(31);
+			reduced_output_stream.write((char *)buffer.data(), k);
+			remaining-= k;
+		}
+	}
+	string_input_stream.close();
+	reduced_output_stream.close();
+#endif
+	return(output_offset);
+}
+
+uint32_t combine_generations(
+	uint8_t *dest,			// output: combined map (M_COM + M_DIV bytes)
+	uint32_t latest)		// input : newest generation
+{
+	// the generations must share the seed (setup time) and be bitmaps,
+	// expired or missing generations of the window are skipped
+	uint32_t combined= 0;
+	vector<uint8_t> buffer(COPY_SIZE);
+	for (uint32_t g= latest; g > 0 && g + GENERATIONS > latest; g--) {
+		ifstream map_input_stream(generation_map_file_name(g), ios::binary);
+		if (!map_input_stream) continue;
+		map_header header;
+		map_input_stream.read((char *)&header, sizeof(map_header));
+		if (header.magic != MAP_MAGIC || header.generation != g || header.backend != BACKEND_BITMAP
+				|| header.map_size != M_COM + M_DIV || header.setup_time != generation_setup_time
+				|| header.fp_family != fp_family || header.sampling != sampling) {
+			if (g == latest) return(0);
+			continue;
+		}
+		for (uint64_t offset= 0; offset < M_COM + M_DIV; offset+= COPY_SIZE) {
+			uint64_t k= min((uint64_t)(M_COM + M_DIV) - offset, (uint64_t)COPY_SIZE);
+			if (g == latest) {
+				map_input_stream.read((char *)dest + offset, k);
+			} else {
+				map_input_stream.read((char *)buffer.data(), k);
+				for (uint64_t i= 0; i < k; i++) dest[offset + i]&= buffer[i];
+			}
+		}
+		combined++;
+	}
+	return(combined);
+}
+
+// trace export
+// ------------
+// Chrome trace JSON: one complete event ("ph":"X") per recorded step, one track per thread
+uint64_t write_trace()
+{
+	const char *thread_name[]= {"scheduler", "worker1 (read)", "worker2 (hash)", "worker3 (probe)"};
+	uint64_t written= 0;
+	ofstream trace_stream(trace_file_name);
+	if (!trace_stream) {
+		cerr << "Can't open trace file!";
+		return(0);
+	}
+	trace_stream << fixed << setprecision(3);
+	trace_stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	for (uint32_t tid= 0; tid < 4; tid++) {
+		trace_stream << (tid ? ",\n" : "") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+				<< ",\"args\":{\"name\":\"" << thread_name[tid] << "\"}}";
+	}
+	for (uint32_t tid= 0; tid < 4; tid++) {
+		const trace_ring &ring= trace_rings[tid];
+		uint64_t first= (ring.count > TRACE_EVENTS) ? ring.count - TRACE_EVENTS : 0;
+		for (uint64_t k= first; k < ring.count; k++) {
+			const trace_event &e= ring.events[k % TRACE_EVENTS];
+			trace_stream << ",\n{\"name\":\"" << trace_kind_name[e.kind];
+			if (e.container != ' ') trace_stream << " " << e.container;
+			trace_stream << "\",\"cat\":\"" << thread_name[tid] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+					<< ",\"ts\":" << e.begin << ",\"dur\":" << e.duration
+					<< ",\"args\":{\"" << (tid ? "batch" : "stage") << "\":" << e.id << "}}";
+			written++;
+		}
+	}
+	trace_stream << "\n]}\n";
+	trace_stream.close();
+	return(written);
+}
+
+// dedup cache
+// -----------
+// chunk hash: 8 bytes per multiply-xorshift step (seed: map id)
+uint64_t chunk_hash(const uint8_t s[], uint64_t size, uint64_t seed)
+{
+	uint64_t h= seed ^ (size * CRC_MIX);
+	uint64_t w;
+	uint64_t i= 0;
+	for (; i + 8 <= size; i+= 8) {
+		memcpy(&w, s + i, 8);
+		h= (h ^ w) * 0xFF51AFD7ED558CCDULL;
+		h^= h >> 32;
+	}
+	w= 0;
+	memcpy(&w, s + i, size - i);
+	h= (h ^ w) * 0xC4CEB9FE1A85EC53ULL;
+	return(h ^ (h >> 33));
+}
+
+int64_t dedup_lookup(			// returns the entry of the chunk, -1: not cached
+	const uint8_t buffer[],		// input : carry and batch
+	uint32_t size,				// input : batch size
+	uint64_t &key)				// output: chunk hash
+{
+	key= chunk_hash(buffer, size + LC, map_id);
+	dedup_lookups++;
+	// binary search
+	uint64_t lo= 0, hi= dedup_entries.size();
+	while (lo < hi) {
+		uint64_t mid= (lo + hi) / 2;
+		if (dedup_entries[mid].key < key) lo= mid + 1; else hi= mid;
+	}
+	if (lo == dedup_entries.size() || dedup_entries[lo].key != key) return(-1);
+	dedup_hits++;
+	return(lo);
+}
+
+void dedup_replay(int64_t entry, uint32_t size)
+{
+	// hit mask of the cached chunk into the run detection (carried across the chunk boundaries)
+	const dedup_entry &e= dedup_entries[entry];
+	memset(batch_hit_mask, 0, sizeof(batch_hit_mask));
+	for (uint32_t r= e.first; r < e.first + e.count; r++) {
+		for (uint32_t i= dedup_runs[r].start; i < dedup_runs[r].start + dedup_runs[r].length; i++) {
+			batch_hit_mask[i >> 6]|= 1ULL << (i & 63);
+		}
+	}
+	detect_runs(test_runs, batch_hit_mask, size);
+}
+
+void dedup_record(uint64_t key, uint32_t size)
+{
+	// hit runs of the batch just checked (batch_hit_mask), including the leading and trailing runs
+	if (dedup_entries.size() + dedup_new_entries.size() >= DEDUP_MAX_ENTRIES) return;
+	dedup_entry e= {key, (uint32_t)dedup_new_runs.size(), 0};
+	uint32_t i= 0;
+	while (i < size) {
+		uint64_t x= batch_hit_mask[i >> 6] >> (i & 63);
+		uint32_t n;
+		if (x & 1) {
+			n= (~x == 0) ? 64 : __builtin_ctzll(~x);
+			if (e.count > 0 && dedup_new_runs.back().start + dedup_new_runs.back().length == i) {
+				dedup_new_runs.back().length+= n;
+			} else {
+				dedup_new_runs.push_back({i, n});
+				e.count++;
+			}
+		} else {
+			n= (x == 0) ? 64 - (i & 63) : __builtin_ctzll(x);
+		}
+		i+= n;
+	}
+	dedup_new_entries.push_back(e);
+}
+
+string dedup_file_name() {
+	char id[17];
+	snprintf(id, sizeof(id), "%016llx", (unsigned long long)map_id);
+	return dedup_file_name_prefix + id + ".txt";
+}
+
+void load_dedup()
+{
+	// cache file: magic, map id, number of entries, number of runs, entries (sorted by key), runs
+	uint64_t head[4];
+	ifstream dedup_stream(dedup_file_name(), ios::binary);
+	if (!dedup_stream) return;		// first run against this map
+	dedup_stream.read((char *)head, sizeof(head));
+	if (dedup_stream.gcount() != sizeof(head) || head[0] != DEDUP_MAGIC || head[1] != map_id) {
+		printf("dedup cache file ignored (incompatible) \n");
+		return;
+	}
+	dedup_entries.resize(head[2]);
+	dedup_runs.resize(head[3]);
+	dedup_stream.read((char *)dedup_entries.data(), head[2] * sizeof(dedup_entry));
+	dedup_stream.read((char *)dedup_runs.data(), head[3] * sizeof(dedup_run));
+	if (!dedup_stream) {
+		printf("dedup cache file ignored (truncated) \n");
+		dedup_entries.clear();
+		dedup_runs.clear();
+	}
+}
+
+void save_dedup()
+{
+	if (dedup_new_entries.empty()) return;
+	// merge the new chunks (the first entry of a key is kept), then compact the runs
+	uint32_t base= dedup_runs.size();
+	for (dedup_entry e : dedup_new_entries) {
+		e.first+= base;
+		dedup_entries.push_back(e);
+	}
+	dedup_runs.insert(dedup_runs.end(), dedup_new_runs.begin(), dedup_new_runs.end());
+	// (key, first): the older entry of a key comes first
+	qsort(dedup_entries.data(), dedup_entries.size(), sizeof(dedup_entry), [](const void *a, const void *b){
+		const dedup_entry *x= (const dedup_entry *)a, *y= (const dedup_entry *)b;
+		if (x->key != y->key) return (x->key > y->key) - (x->key < y->key);
+		return (x->first > y->first) - (x->first < y->first); });
+	vector<dedup_entry> entries;
+	vector<dedup_run> runs;
+	for (dedup_entry e : dedup_entries) {
+		if (!entries.empty() && entries.back().key == e.key) continue;
+		runs.insert(runs.end(), dedup_runs.begin() + e.first, dedup_runs.begin() + e.first + e.count);
+		e.first= runs.size() - e.count;
+		entries.push_back(e);
+	}
+	dedup_entries.swap(entries);
+	dedup_runs.swap(runs);
+	uint64_t head[4]= {DEDUP_MAGIC, map_id, dedup_entries.size(), dedup_runs.size()};
+	ofstream dedup_stream(dedup_file_name(), ios::binary);
+	if (!dedup_stream) {
+		cerr << "Can't open dedup cache file!";
+		return;
+	}
+	dedup_stream.write((char *)head, sizeof(head));
+	dedup_stream.write((char *)dedup_entries.data(), dedup_entries.size() * sizeof(dedup_entry));
+	dedup_stream.write((char *)dedup_runs.data(), dedup_runs.size() * sizeof(dedup_run));
+	dedup_stream.close();
+}
+
+// chunk matching
+// --------------
+void cdc_scan(
+	const uint8_t input_buffer[],	// input : bytes of the batch (shuffled, as in scatter)
+	uint32_t size,					// input : batch size
+	bool last)						// input : last batch, the end of S closes the current chunk
+{
+	// worker1: a chunk ends where the top CDC_BITS of the gear hash are zero (CDC_MIN_SIZE .. CDC_MAX_SIZE bytes),
+	// the boundaries depend on the contents only: s and S are cut alike in their common regions
+	// (gear hash and length in registers, the bytes of a chunk are staged only across batch boundaries)
+	cdc_state &cs= test_chunking;
+	uint64_t gear= cs.gear;
+	uint32_t length= cs.length;		// bytes of the current chunk (cs.length of them staged)
+	uint32_t from= 0;				// first byte of the current chunk in the batch
+	for (uint32_t j= 0; j < size; j++) {
+		if (length < CDC_MIN_SIZE - 64 && j < size - 1) {
+			// the first boundary test (length CDC_MIN_SIZE) depends on the last 64 bytes only
+			uint32_t k= min(CDC_MIN_SIZE - 64 - length, size - 1 - j);
+			length+= k;
+			j+= k - 1;
+			continue;
+		}
+		gear= (gear << 1) + GEAR_TABLE[input_buffer[j]];
+		length++;
+		if (!((length >= CDC_MIN_SIZE && (gear >> (64 - CDC_BITS)) == 0) || length == CDC_MAX_SIZE
+				|| (last && j == size - 1))) continue;
+		const uint8_t *bytes= input_buffer + from;
+		if (cs.length > 0) {
+			memcpy(cs.bytes + cs.length, bytes, j + 1 - from);
+			bytes= cs.bytes;
+		}
+		uint64_t key= chunk_hash(bytes, length, 0);
+		cdc_test_chunks++;
+		// binary search
+		uint64_t lo= 0, hi= cdc_chunks.size();
+		while (lo < hi) {
+			uint64_t mid= (lo + hi) / 2;
+			if (cdc_chunks[mid].key < key) lo= mid + 1; else hi= mid;
+		}
+		// the chunks of s with this hash and length: a match is confirmed by its bytes in s
+		for (; length >= LP && lo < cdc_chunks.size() && cdc_chunks[lo].key == key; lo++) {
+			if (cdc_chunks[lo].length != length) continue;
+			if (!read_master(cdc_reference_stream, cdc_chunks[lo].offset, cs.reference, length)
+					|| memcmp(cs.reference, bytes, length) != 0) {
+				cdc_collisions++;
+				continue;
+			}
+			// pass the match to worker3 (ring slot first, then the count)
+			uint64_t k= cdc_pushed.load(memory_order_relaxed);
+			cdc_ring[k % CDC_RING]= {cs.start, cdc_chunks[lo].offset, length};
+			cdc_pushed.store(k + 1, memory_order_release);
+			break;
+		}
+		cs.start+= length;
+		cs.length= 0;
+		length= 0;
+		from= j + 1;
+	}
+	// stage the open chunk
+	memcpy(cs.bytes + cs.length, input_buffer + from, size - from);
+	cs.length= length;
+	cs.gear= gear;
+}
+
+void cdc_check_batch(
+	uint32_t j0,			// input : first hash to check
+	uint32_t hash_count,	// input : number of hashes
+	com_t com_hash[],	// input : batch of hash_count common hashes
+	uint8_t  div_hash[][BATCH_SIZE]) // input : DV lanes of hash_count diversified hashes
+{
+	// worker3: the shingles inside a matched chunk (offsets test_offset .. test_offset + length - L) are misses
+	// without probes, the segments between them are checked. A match is decided by worker1 at the latest
+	// one stage after the batch of its first byte (length <= CDC_MAX_SIZE <= BATCH_SIZE), before worker3 gets there
+	uint64_t pushed= cdc_pushed.load(memory_order_acquire);
+	uint32_t j= j0;
+	while (j < hash_count) {
+		uint64_t p= test_runs.position;			// offset in S of shingle j
+		uint64_t q= p + hash_count - j;			// end of the batch
+		if (cdc_consumed == pushed || cdc_ring[cdc_consumed % CDC_RING].test_offset >= q) {
+			check_batch(j, hash_count, com_hash, div_hash);
+			return;
+		}
+		const cdc_match &m= cdc_ring[cdc_consumed % CDC_RING];
+		uint64_t first= max(m.test_offset, p);
+		uint64_t end= min(m.test_offset + m.length - L + 1, q);
+		if (first > p) {
+			check_batch(j, j + (first - p), com_hash, div_hash);
+			j+= first - p;
+		}
+		if (end > first) {
+			uint32_t count= end - first;
+			memset(batch_hit_mask, 0, (count + 63) / 64 * sizeof(uint64_t));
+			detect_runs(test_runs, batch_hit_mask, count);
+			cdc_skipped+= count;
+			j+= count;
+		}
+		if (m.test_offset + m.length - L + 1 <= q) {
+			// chunk completed: confirmed (adjacent in S and s: one common substring)
+			if (!confirmed.empty() && confirmed.back().test_offset + confirmed.back().length == m.test_offset
+					&& confirmed.back().reference_offset + confirmed.back().length == m.reference_offset) {
+				confirmed.back().length+= m.length;
+			} else {
+				confirmed.push_back(m);
+			}
+			cdc_confirmed_bytes+= m.length;
+			cdc_consumed++;
+		}
+	}
+}
+
+bool load_chunks(time_t setup_time)
+{
+	// chunk file: magic, setup time, CDC_MIN_SIZE, CDC_MAX_SIZE, CDC_BITS, number of chunks, chunks (sorted by key)
+	uint64_t head[6];
+	ifstream chunk_stream(chunk_file_name(), ios::binary);
+	if (!chunk_stream) return(false);
+	chunk_stream.read((char *)head, sizeof(head));
+	if (chunk_stream.gcount() != sizeof(head) || head[0] != CDC_MAGIC || head[1] != (uint64_t)setup_time
+			|| head[2] != CDC_MIN_SIZE || head[3] != CDC_MAX_SIZE || head[4] != CDC_BITS) {
+		printf("chunk file ignored (incompatible) \n");
+		return(false);
+	}
+	cdc_chunks.resize(head[5]);
+	chunk_stream.read((char *)cdc_chunks.data(), head[5] * sizeof(cdc_chunk));
+	if (!chunk_stream) {
+		printf("chunk file ignored (truncated) \n");
+		cdc_chunks.clear();
+		return(false);
+	}
+	return(true);
+}
+
+uint64_t write_confirmed(string file_name)
+{
+	// one line per confirmed common substring
+	ofstream confirmed_stream(file_name);
+	if (!confirmed_stream) {
+		cerr << "Can't open confirmed output file!";
+		exit(30);
+	}
+	confirmed_stream << "# test string offset, reference string offset, length [bytes]\n";
+	for (const cdc_match &m : confirmed) {
+		confirmed_stream << m.test_offset << " " << m.reference_offset << " " << m.length << "\n";
+	}
+	confirmed_stream.close();
+	return(confirmed.size());
+}
+
+bool read_master(
+	ifstream &string_input_stream,	// input : master file
+	uint64_t offset,				// input : offset in the master file (s: 0 .. ns-1, S: ns ..)
+	uint8_t buffer[],				// output: bytes
+	uint64_t size)					// input : number of bytes
+{
+	// "Demo-String": 20 zero bytes in s (cf. scatter) and in S (cf. worker1)
+	const uint64_t demo_offset[2]= {(ns / BATCH_SIZE / 2 - 1) * BATCH_SIZE, ns + (N / BATCH_SIZE / 3) * BATCH_SIZE - 10};
+	string_input_stream.clear();
+	string_input_stream.seekg(offset, string_input_stream.beg);
+	string_input_stream.read((char *)buffer, size);
+	if (size != (uint64_t)string_input_stream.gcount()) return(false);
+	for (uint64_t j= 0; j < size; j++) buffer[j]= shuffle[buffer[j]];
+	for (uint64_t demo : demo_offset) {
+		for (uint64_t i= max(demo, offset); i < min(demo + 20, offset + size); i++) buffer[i - offset]= 0;
+	}
+	return(true);
+}
+
+// existence mode
+// --------------
+void existence_check()
+{
+	// candidates: the confirmed chunks (CDC), the new closed survivor runs and the open run once it reaches
+	// the threshold. A run is verified by all its windows of LP bytes: the open run by the windows it has,
+	// the run once closed by the windows it got since
+	bool found= false;
+	if (!confirmed.empty()) {
+		existence_test_offset= confirmed[0].test_offset;
+		existence_reference_offset= confirmed[0].reference_offset;
+		found= true;
+	}
+	while (!found && existence_next_run < test_runs.runs.size()) {
+		const survivor_run &run= test_runs.runs[existence_next_run++];
+		uint64_t windows= run.length - LT + 1;
+		uint64_t first= (run.start == existence_open_start) ? existence_open_windows : 0;	// verified while open
+		if (first == windows) continue;
+		existence_candidates++;
+		existence_test_offset= run.start + first;
+		found= !VERIFIABLE || verify_candidate(run.start + first, windows - first, existence_test_offset, existence_reference_offset);
+	}
+	if (!found && test_runs.count >= test_runs.threshold && test_runs.start - test_runs.extent != existence_open_start) {
+		existence_open_start= test_runs.start - test_runs.extent;
+		existence_open_windows= test_runs.count + test_runs.extent - LT + 1;
+		existence_candidates++;
+		existence_test_offset= existence_open_start;
+		found= !VERIFIABLE || verify_candidate(existence_open_start, existence_open_windows, existence_test_offset, existence_reference_offset);
+	}
+	if (found) {
+		existence_verified= !confirmed.empty() || VERIFIABLE;
+		existence_time= get_elapsed_time(trace_epoch);
+		existence_found= true;
+	}
+}
+
+bool verify_candidate(
+	uint64_t start,					// input : offset in S of the first window
+	uint64_t windows,				// input : number of windows (LP bytes, consecutive)
+	uint64_t &test_offset,			// output: offset in S of a window found in s
+	uint64_t &reference_offset)		// output: offset in s of its occurrence
+{
+	// S and s are compared as the workers of gather and scatter see them (shuffled, "Demo-String"):
+	// the windows are hashed into a table (linear probing) and a bit filter (>= 64 bits per window: the
+	// branch on a filter hit is predictable), s is scanned in blocks of COPY_SIZE bytes (overlap LP-1) with
+	// the rolling hash of its windows, a table hit is compared byte-wise
+	ifstream string_input_stream(master_string_file_name, ios::in|ios::binary);
+	if (!string_input_stream) {
+		cerr << "Can't open master file!";
+		return(false);
+	}
+	const uint64_t base= 0x9E3779B97F4A7C15ULL;		// rolling hash modulo 2^64 (odd base)
+	uint64_t power= 1;								// base^LP
+	for (uint32_t j= 0; j < LP; j++) power*= base;
+	vector<uint8_t> run(windows + LP - 1);
+	if (!read_master(string_input_stream, ns + start, run.data(), run.size())) return(false);
+	uint32_t bits= 1;
+	while ((1ULL << bits) < 2 * windows) bits++;
+	uint64_t mask= (1ULL << bits) - 1;
+	vector<uint64_t> table_hash(mask + 1);
+	vector<uint64_t> table_window(mask + 1, ~0ULL);	// window of the slot (~0: empty)
+	uint32_t filter_bits= 16;
+	while ((1ULL << filter_bits) < 64 * windows) filter_bits++;
+	vector<uint64_t> filter((1ULL << filter_bits) / 64);
+	uint64_t h= 0;
+	for (uint64_t i= 0; i < run.size(); i++) {
+		h= h * base + run[i];
+		if (i >= LP) h-= power * run[i - LP];
+		if (i + 1 < LP) continue;
+		filter[h >> (64 - filter_bits + 6)]|= 1ULL << ((h >> (64 - filter_bits)) & 63);
+		uint64_t slot= h >> (64 - bits);
+		while (table_window[slot] != ~0ULL) slot= (slot + 1) & mask;
+		table_hash[slot]= h;
+		table_window[slot]= i + 1 - LP;
+	}
+	vector<uint8_t> block(COPY_SIZE + LP - 1);
+	uint64_t kept= 0;		// bytes of the previous block (overlap)
+	for (uint64_t offset= 0; offset < ns; ) {
+		uint64_t k= min((uint64_t)COPY_SIZE, (uint64_t)(ns - offset));
+		if (!read_master(string_input_stream, offset, block.data() + kept, k)) return(false);
+		uint64_t size= kept + k;
+		h= 0;
+		for (uint64_t i= 0; i < size; i++) {
+			h= h * base + block[i];
+			if (i >= LP) h-= power * block[i - LP];
+			if (i + 1 < LP || !((filter[h >> (64 - filter_bits + 6)] >> ((h >> (64 - filter_bits)) & 63)) & 1)) continue;
+			for (uint64_t slot= h >> (64 - bits); table_window[slot] != ~0ULL; slot= (slot + 1) & mask) {
+				uint64_t w= table_window[slot];
+				if (table_hash[slot] == h && memcmp(block.data() + i + 1 - LP, run.data() + w, LP) == 0) {
+					test_offset= start + w;
+					reference_offset= offset - kept + (i + 1 - LP);
+					return(true);
+				}
+			}
+		}
+		kept= min(size, (uint64_t)LP - 1);
+		memmove(block.data(), block.data() + size - kept, kept);
+		offset+= k;
+	}
+	return(false);
+}
+
+// progress reporter
+// -----------------
+// samples the stage counters every PROGRESS_MS: MB/s of the last interval and of the run,
+// residue rate and ETA (total_bytes == 0: unknown, streaming)
+void progress_thread(uint64_t total_bytes)
+{
+	ofstream metrics_stream;
+	if (METRICS_FILE) {
+		metrics_stream.open(metrics_file_name);
+		if (!metrics_stream) cerr << "Can't open metrics file!";
+		metrics_stream << "elapsed_ms;bytes;hashed;probes;residue;mb_per_s;residue_per_s;eta_s\n";
+	}
+	Time start_time= start_timer();
+	double last_time= 0;
+	uint64_t last_bytes= 0;
+	uint64_t last_residue= 0;
+	while (!progress_stop) {
+		this_thread::sleep_for(chrono::milliseconds(min(PROGRESS_MS, 100)));
+		double t= get_elapsed_time(start_time);
+		if (t - last_time < PROGRESS_MS) continue;
+		uint64_t bytes= progress_bytes.load(memory_order_relaxed);
+		uint64_t hashed= progress_hashed.load(memory_order_relaxed);
+		uint64_t probes= progress_probes.load(memory_order_relaxed);
+		uint64_t residue= progress_residue.load(memory_order_relaxed);
+		double rate= (bytes - last_bytes) / (1000.0 * (t - last_time));		// [mega bytes / second]
+		double residue_rate= (residue - last_residue) * 1000.0 / (t - last_time);
+		double eta= (total_bytes > 0 && bytes > 0) ? (total_bytes - min(bytes, total_bytes)) * t / bytes / 1000.0 : -1;
+		printf("progress %7.1f s : %10.1f MB \t%6.1f MB/s (run %6.1f), residue %llu (%.1f / s)",
+				t / 1000.0, bytes / 1e6, rate, bytes / (1000.0 * t), residue, residue_rate);
+		if (eta >= 0) printf(", %4.1f%%, ETA %6.0f s \n", 100.0 * bytes / total_bytes, eta); else printf(" \n");
+		fflush(stdout);
+		if (METRICS_FILE) {
+			metrics_stream << (uint64_t)t << ";" << bytes << ";" << hashed << ";" << probes << ";" << residue << ";"
+					<< rate << ";" << residue_rate << ";" << eta << endl;
+		}
+		last_time= t;
+		last_bytes= bytes;
+		last_residue= residue;
+	}
+}
+
+void refresh_thread()
+{
+	// poll for the next generation, build the combined map in spare_map
+	while (!refresh_stop) {
+		this_thread::sleep_for(chrono::milliseconds(REFRESH_MS));
+		if (refresh_ready.load(memory_order_acquire)) continue;	// not yet taken over
+		ifstream generation_stream(generation_map_file_name(latest_generation + 1), ios::binary);
+		if (!generation_stream) continue;
+		generation_stream.close();
+		if (combine_generations(spare_map, latest_generation + 1) == 0) continue;
+		latest_generation++;
+		refresh_ready.store(true, memory_order_release);
+	}
+}
+
 void rcp_generator(std::mt19937& mt_rand, uint8_t p[]) {
     std::uniform_int_distribution<uint8_t> dist(0, 255);
 	// p: random cyclic permutations (see Sattolo / FisherYates)
@@ -1014,7 +3330,7 @@ void rcp_generator(std::mt19937& mt_rand, uint8_t p[]) {
 	}
 }
 
-time_t load_hash_map(string map_file_name) {
+time_t load_hash_map(string map_file_name, uint32_t round) {
 	//read hash map and return the setup time
 	// setup time
 	time_t  setup_time;
@@ -1029,19 +3345,65 @@ time_t load_hash_map(string map_file_name) {
 	// length of map file
 	map_input_stream.seekg (0, map_input_stream.end);
 	uint64_t map_length= (uint64_t)map_input_stream.tellg();
-	printf("map file length:  %llu (incl. prefixed setup time) \n", map_length);
-	if (map_length < M_COM+M_DIV) {
-		printf("hash map file length < M_COM+M_DIV : %llu, %llu \n", M_COM, M_DIV);
+	printf("map file length:  %llu (incl. prefixed map header) \n", map_length);
+	if (map_length < sizeof(map_header)) {
+		printf("hash map file length < map header : %llu \n", (uint64_t)sizeof(map_header));
 		fflush(stdout);
 		exit(27);
 	}
 	// position the input stream at the beginning
 	map_input_stream.seekg (0, map_input_stream.beg);
-	// read setup time
-	map_input_stream.read((char *)p_time, sizeof(time_t));
+	if (map_length == sizeof(time_t) + M_COM+M_DIV) {
+		// legacy map file: prefixed setup time only, Rabin-Karp fingerprints of all shingles (first round)
+		if (round != 1 || ENGINE != ENGINE_DIVERSIFIED) exit(28);
+		map_input_stream.read((char *)p_time, sizeof(time_t));
+		map_id= chunk_hash((uint8_t *)p_time, sizeof(time_t), L);
+		fp_family= FP_RABIN_KARP;
+		sampling= SAMPLE_ALL;
+		backend= BACKEND_BITMAP;
+		map_size= M_COM+M_DIV;
+		m_map= M_COM;
+	} else {
+		// read map header
+		map_header header;
+		map_input_stream.read((char *)&header, sizeof(map_header));
+		if (header.magic != MAP_MAGIC || header.m_com != M_COM || header.m_div != M_DIV
+				|| header.fp_family > FP_CRC32C || header.sampling > SAMPLE_MINIMIZER
+				|| (header.sampling == SAMPLE_MINIMIZER && header.window != LT) || header.round != round
+				|| header.engine != ENGINE || header.backend > BACKEND_COUNTING
+				|| (header.backend == BACKEND_BLOOM && header.bloom_k != BLOOM_K)
+				|| map_length != sizeof(map_header) + header.map_size) {
+			printf("incompatible hash map header : M_COM %llu, M_DIV %llu, family %u, sampling %u, window %u, round %u, engine %u, backend %u \n",
+					(unsigned long long)header.m_com, (unsigned long long)header.m_div, header.fp_family,
+					header.sampling, header.window, header.round, header.engine, header.backend);
+			fflush(stdout);
+			exit(28);
+		}
+		setup_time= header.setup_time;
+		map_id= chunk_hash((uint8_t *)&header, sizeof(map_header), L);
+		fp_family= header.fp_family;
+		sampling= header.sampling;
+		backend= header.backend;
+		map_size= header.map_size;
+		filter_seed= header.filter_seed;
+		if (header.fold > 0 && (header.backend != BACKEND_BITMAP || header.map_size != header.fold + M_DIV)) exit(28);
+		m_map= (header.fold > 0) ? header.fold : M_COM;
+	}
+	map_offset= map_length - map_size;
+	if (OUT_OF_CORE) {
+		// header only: the map is streamed region by region (out_of_core_gather)
+		map_input_stream.close();
+		return(setup_time);
+	}
+	// hash map allocation
+	free(map);
+	map= alloc_map(map_size + MAP_PAD); if (map == NULL) exit(11);
+	// padding read by the 4 byte gathers of the vectorized probe (never cleared)
+	memset(map + map_size, 0b11111111, MAP_PAD);
 	// read hash map
-	map_input_stream.read((char *)map, M_COM+M_DIV);
+	map_input_stream.read((char *)map, map_size);
 	map_input_stream.close();
+	if (PROBE_CACHE) probe_cache_clear();
 	return(setup_time);
 }
 
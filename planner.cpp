@@ -0,0 +1,160 @@
+// ==================================================================================
+// Name        : planner.cpp
+// Author      : Felix Baessler
+// Version     : 17.10.2026
+// Copyright   : Felix Baessler, felix.baessler@gmail.com
+// SEE TLDR; VERSION OF THE LICENSE: https://creativecommons.org/licenses/by-nc/4.0/legalcode
+// SEE FULL LICENSE DETAILS HERE   : https://creativecommons.org/licenses/by-nc/4.0/
+//
+// Description :
+// Planner recommends the map modulus M_COM, the shingle length L and the prefix length LP
+// for given string lengths (ns, NS), a RAM budget, a cache size and a target residue.
+// Filtration model (cf. gather, expected optimum (1 - 1/e) ^ (DV*(LP-L+1)) for ns == M_COM):
+// -	occupancy of a cofilter slot     : rho= 1 - exp(-ns / M_COM)
+// -	hit probability of a test shingle : h= q + rho ^ DV, q= 1 - exp(-ns / 256^L) (true L-byte match)
+// -	expected residue                  : NS * h ^ (LP-L+1)
+// For each (L, LP) the smallest prime M_COM meeting the target is taken, the parameter set
+// with the smallest LP and, among those, the shortest expected gather time is recommended.
+// The run times are estimated from the per shingle costs measured by gather (time expenditure).
+// The recommendation is written to the config file v1_config.h, included by scatter and gather
+// when they are compiled in the same directory.
+// DV= 8 and M_DIV= 67 are fixed (byte packed diversified hashes).
+// ==================================================================================
+
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+using namespace std;
+
+// problem
+#define ns      1000000000ULL 		// length of the reference string s [bytes]
+#define NS      100000000ULL		// length of the test string S [bytes]
+#define TARGET_RESIDUE  100.0		// expected residue (random survivors of S)
+#define LP_MIN   8					// range of the prefix length
+#define LP_MAX  32
+#define L_MIN    4					// range of the shingle length
+#define L_MAX    8
+// machine
+#define RAM_BUDGET  (4ULL << 30)	// memory of the map [bytes]
+#define CACHE_SIZE  (32ULL << 20)	// last level cache [bytes]
+// measured costs [nanoseconds per shingle] (gather: worker process time / N)
+#define HASH_NS         8.0			// worker2: hashing
+#define PROBE_CACHE_NS  4.0			// worker3: map resident in the cache
+#define PROBE_DRAM_NS  60.0			// worker3: map in DRAM
+#define READ_MBS      500.0			// sequential read rate [mega bytes / second] (master and map file)
+// fixed parameters (same values in scatter and gather)
+#define DV   8
+#define M_DIV   67ULL
+// output
+const string config_file_name= "v1_config.h";
+
+bool is_prime(uint64_t m) {
+	if (m < 2) return(false);
+	for (uint64_t d= 2; d * d <= m; d++) {
+		if (m % d == 0) return(false);
+	}
+	return(true);
+}
+
+double expected_residue(uint64_t m_com, uint32_t l, uint32_t lp) {
+	double rho= 1.0 - exp(-(double)ns / m_com);
+	double q= 1.0 - exp(-(double)ns / pow(256.0, l));
+	return(NS * pow(q + pow(rho, DV), lp - l + 1));
+}
+
+double gather_time(uint64_t m_com, uint32_t l) {
+	// [milliseconds]: load the map, the three stages overlap (the slowest one dominates)
+	uint64_t map_size= m_com + M_DIV;
+	double probe_ns= (map_size <= CACHE_SIZE) ? PROBE_CACHE_NS : PROBE_DRAM_NS;
+	double read_ns= 1000.0 / READ_MBS;
+	return(map_size / (1000.0 * READ_MBS) + (NS - l + 1) * max(max(HASH_NS, probe_ns), read_ns) / 1e6);
+}
+
+int
+main()
+{
+	printf("\n");
+	printf("planner_v1 \n");
+	printf("========== \n");
+	printf("string s length ns    : %llu \t(reference string s) \n", ns);
+	printf("string S length NS    : %llu \t(test string S) \n", NS);
+	printf("target residue        : %.1f \n", TARGET_RESIDUE);
+	printf("RAM budget            : %llu [bytes] \n", RAM_BUDGET);
+	printf("cache size            : %llu [bytes] \n", CACHE_SIZE);
+	printf("\n");
+
+	// search (L, LP), smallest M_COM per pair
+	// ---------------------------------------
+	bool found= false;
+	uint32_t best_l= 0, best_lp= 0;
+	uint64_t best_m_com= 0;
+	double best_time= 0;
+	printf("  L  LP        M_COM     residue   gather [ms] \n");
+	for (uint32_t lp= LP_MIN; lp <= LP_MAX && !found; lp++) {
+		for (uint32_t l= L_MIN; l <= L_MAX && l < lp; l++) {
+			// hit probability required by the target, then the largest occupancy
+			double h= pow(TARGET_RESIDUE / NS, 1.0 / (lp - l + 1));
+			double q= 1.0 - exp(-(double)ns / pow(256.0, l));
+			if (h <= q) continue;
+			double rho= pow(h - q, 1.0 / DV);
+			if (rho >= 1.0) rho= 0.999999;
+			double m_min= -(double)ns / log(1.0 - rho);
+			if (m_min + M_DIV > RAM_BUDGET) continue;
+			uint64_t m_com= max((uint64_t)ceil(m_min), (uint64_t)257);
+			while (!is_prime(m_com) || expected_residue(m_com, l, lp) > TARGET_RESIDUE) m_com++;
+			if (m_com + M_DIV > RAM_BUDGET) continue;
+			double t= gather_time(m_com, l);
+			printf("%3u %3u %12llu %11.3f %13.0f \n", l, lp, m_com, expected_residue(m_com, l, lp), t);
+			if (!found || t < best_time) {
+				found= true;
+				best_l= l;
+				best_lp= lp;
+				best_m_com= m_com;
+				best_time= t;
+			}
+		}
+	}
+	if (!found) {
+		printf("no parameter set meets the target residue within the RAM budget \n");
+		fflush(stdout);
+		exit(10);
+	}
+
+	// recommendation
+	// --------------
+	uint64_t map_size= best_m_com + M_DIV;
+	printf("\n");
+	printf("recommendation \n");
+	printf("-------------- \n");
+	printf("M_COM                 : %llu \t(prime) \n", best_m_com);
+	printf("shingle length L      : %u \n", best_l);
+	printf("prefix  length LP     : %u \n", best_lp);
+	printf("expected residue      : %.3f \t(NS * (q + rho^DV) ^ (LP-L+1)) \n", expected_residue(best_m_com, best_l, best_lp));
+	printf("map memory            : %llu [bytes] \t(%s, %s bit common hashes) \n", map_size,
+			map_size <= CACHE_SIZE ? "cache resident" : "DRAM", map_size >= (1ULL << 31) ? "64" : "32");
+	printf("expected time scatter : %9.0f [milliseconds] \n",
+			map_size / (1000.0 * READ_MBS) + ns * max(max(HASH_NS, PROBE_DRAM_NS), 1000.0 / READ_MBS) / 1e6);
+	printf("expected time gather  : %9.0f [milliseconds] \n", best_time);
+
+	// config file (scatter and gather)
+	// -----------
+	ofstream config_stream(config_file_name);
+	if (!config_stream) {
+		cerr << "Can't open config file!";
+		exit(11);
+	}
+	config_stream << "// " << config_file_name << ": written by planner (target residue " << TARGET_RESIDUE
+			<< ", RAM budget " << RAM_BUDGET << " bytes)\n";
+	config_stream << "#define ns      " << ns << "ULL\n";
+	config_stream << "#define NS      " << NS << "ULL\n";
+	config_stream << "#define M_COM   " << best_m_com << "ULL\n";
+	config_stream << "#define L_SHINGLE  " << best_l << "\n";
+	config_stream << "#define LP  " << best_lp << "\n";
+	config_stream.close();
+	printf("config file           : %s \n", config_file_name.c_str());
+	printf("\n");
+	printf("end \n");
+}
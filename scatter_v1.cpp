@@ -23,6 +23,8 @@
 //
 // Compilation flags:
 // -O3 -g3 -Wall         : optimization
+// -mavx2 (-march=native): SIMD hashing kernel (scalar fallback otherwise)
+// -msse4.2               : hardware CRC32C fingerprints (table fallback otherwise)
 // -Wl,--stack,0xFFFFFF  : long arrays
 // if required: upgrade minGW to x86_64 : 64 bit executable
 //
@@ -37,8 +39,16 @@
 // ================================================================================
 
 #include <iostream>
+#include <iomanip>
 #include <fstream>
 #include <random>
+#include <array>
+#include <vector>
+#include <cstring>
+#include <atomic>
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
 #include "mingw.thread.h"
 #include "mingw.mutex.h"
 #include "mingw.condition_variable.h"
@@ -63,26 +73,140 @@ void rcp_generator(std::mt19937& mt_rand, uint8_t p[]);
 const string master_string_file_name= "C:\\cr\\master.txt";
 // output: write the hash map
 const string map_file_name_prefix=    "C:\\cr\\v1_map_";
+// input/output: counting map (BACKEND_COUNTING), the bitmap exported from it is written to the map file
+const string counting_map_file_name_prefix= "C:\\cr\\v1_cmap_";
+// live progress (PROGRESS_MS > 0): a reporter thread samples the stage counters every PROGRESS_MS and prints
+// throughput and ETA, optionally also to the metrics file (one line per sample, ";" separated)
+const string metrics_file_name= "C:\\cr\\v1_metrics_scatter.txt";
+#define PROGRESS_MS  5000	// reporter interval [milliseconds] (0: no reporter)
+#define METRICS_FILE  0		// 1: write the samples to the metrics file
+// pipeline trace (TRACE 1): begin/end of every wait and process step of the workers per container (A,B,C)
+// and of the scheduler signals, recorded in per-thread ring buffers and written as Chrome trace JSON
+// (chrome://tracing, ui.perfetto.dev) after the run
+const string trace_file_name= "C:\\cr\\v1_trace_scatter.json";
+#define TRACE  0
+#define TRACE_EVENTS  (1 << 16)	// ring buffer per thread: the latest TRACE_EVENTS events are kept
+// content-defined chunks (CDC 1): worker1 cuts s into content-defined chunks (gear hash boundaries) and records
+// them in the chunk file, gather matches the chunks of S against them (long common regions are confirmed
+// without per-shingle filtering)
+const string chunk_file_name_prefix= "C:\\cr\\v1_chunks_";
+#define CDC  0
+#define CDC_MIN_SIZE  1024		// chunk length [bytes] (same values in scatter and gather: chunk file header)
+#define CDC_MAX_SIZE  8192
+#define CDC_BITS  12			// boundary: the top CDC_BITS of the gear hash are zero (mean chunk ~ CDC_MIN_SIZE + 4 KB)
+#define CDC_MAGIC  0x31434443U	// "CDC1"
+// machine profile: autotune.cpp writes v1_profile.h (batch size, prefetch distance, huge pages, affinity masks),
+// it overrides the defaults below
+#if __has_include("v1_profile.h")
+#include "v1_profile.h"
+#endif
 // batch size of input buffers and hash values (cf. CONTAINERS)
+#ifndef BATCH_SIZE
 #define BATCH_SIZE   (8*1024)
+#endif
+#ifndef PREFETCH_DISTANCE
+#define PREFETCH_DISTANCE  0		// map prefetch: shingles ahead of the current one (0: none)
+#endif
+#ifndef HUGEPAGES
+#define HUGEPAGES  0				// 1: map on transparent huge pages (madvise, linux)
+#endif
+#ifndef AFFINITY_PIPELINE
+#define AFFINITY_PIPELINE  7ULL		// affinity mask of worker1 and worker2
+#define AFFINITY_PROBE     8ULL		// affinity mask of worker3 (map access)
+#endif
+// map allocation (after the machine profile: HUGEPAGES): on transparent huge pages (linux) the random map
+// accesses cause fewer TLB misses
+#if HUGEPAGES && defined(__linux__)
+#include <sys/mman.h>
+#endif
+uint8_t *alloc_map(uint64_t size) {
+#if HUGEPAGES && defined(__linux__)
+	const uint64_t huge_page= 1ULL << 21;
+	uint64_t length= (size + huge_page - 1) / huge_page * huge_page;
+	uint8_t *p= (uint8_t *)aligned_alloc(huge_page, length);
+	if (p != NULL) madvise(p, length, MADV_HUGEPAGE);
+	return(p);
+#else
+	return((uint8_t *)malloc(size));
+#endif
+}
 
 // GLOBAL PARAMETERS: same values in scatter and gather!
 // =================
 
+// shingling engines (recorded in the map header)
+#define ENGINE_DIVERSIFIED  0	// L-shingles: a common substring of length LP is a run of LP-L+1 hits
+#define ENGINE_PREFIX       1	// prefix shingling: LP-shingles, a common substring of length LP is a single hit
+#define ENGINE  ENGINE_DIVERSIFIED	// same engine in scatter and gather (map header)
+const char *engine_name[]= {"diversified L-shingles", "prefix shingling"};
 #define DV   8		// number of diversified hashes == 8 for this implementation (byte packed!!)
-#define L    5		// shingle length L
+// planner configuration: planner.cpp writes v1_config.h (ns, NS, M_COM, L_SHINGLE, LP), it overrides the defaults below
+#if __has_include("v1_config.h")
+#include "v1_config.h"
+#endif
+#ifndef LP
+#define LP  10		// prefix length (>= L): minimizer window LT= LP-L+1
+#endif
+#ifndef L_SHINGLE
+#define L_SHINGLE  5	// shingle length of the diversified engine
+#endif
+#define L    ((ENGINE == ENGINE_PREFIX) ? LP : L_SHINGLE)		// shingle length L
 #define LC  (L-1)	// shingle carry length : LC == L - 1
+#ifndef ns
 #define ns      1000000000ULL 		// length of the reference string s [bytes]
+#endif
 // n is lengthened by the first L-1 test bytes (overlap with reference/test string)
 #define n		ns 					// number of reference shingles
+#ifndef M_COM
 #define M_COM   1000000007ULL		// modulus of the common hashes
+#endif
 #define B_COM   257ULL				// base of the common hashes (first prime > 256)
 #define M_DIV   67ULL
+// common hashes: 32 bit, 64 bit for maps of 2^31 bytes and more (no 32 bit vector gathers)
+#define WIDE_MAP  (M_COM + M_DIV >= (1ULL << 31))
+#if WIDE_MAP
+typedef uint64_t com_t;
+#else
+typedef uint32_t com_t;
+#endif
+#define FP_FAMILY  FP_RABIN_KARP	// fingerprint family of the map (gather reads it from the map header)
+#define SAMPLING   SAMPLE_ALL		// shingle sampling of the map (gather reads it from the map header)
+#define BACKEND    BACKEND_BITMAP	// filter backend of the map (gather reads it from the map header)
+#define GENERATION  0				// 0: single map, g >= 1: generation g of a sliding reference window (map file suffix "_g<g>")
+#define GENERATIONS_KEPT  8			// generation map files kept (scatter deletes the expired generation)
+#define REFERENCE_OFFSET  0ULL		// master file offset of the reference data (epoch of the generation)
+#define COUNTING_UPDATE  0			// BACKEND_COUNTING, 1: update the counting map file instead of scattering s
+// counting update: reference byte ranges [begin, end) of the master file, e.g. { {REFERENCE_OFFSET, REFERENCE_OFFSET + 1000000} }
+// (begin >= REFERENCE_OFFSET, end <= REFERENCE_OFFSET + ns), a range is removed with the content it had when it was added
+#define ADD_RANGES  {}				// ranges hashed into the counting map
+#define REMOVE_RANGES  {}			// ranges removed from the counting map
+// sparse map: a bitmap of low occupancy (ns << M_COM) is folded to fold + M_DIV bytes (fold < M_COM),
+// slot i of the folded map is the AND of the slots i + k*fold, its first M_DIV slots are replicated
+// at the end, gather probes (com % fold) + div[id]
+#define SPARSE_MAP  1				// 1: fold the bitmap when it shrinks at least by SPARSE_MIN_FOLD
+#define SPARSE_OCCUPANCY  0.25		// target occupancy of the folded map
+#define SPARSE_MIN_FOLD  4
+#define SPARSE_MIN_SIZE  ((uint64_t)1 << 16)	// minimum modulus of the folded map
+// LLC resident fold: when the SPARSE_OCCUPANCY fold exceeds LLC_SIZE, the map is folded to LLC_SIZE instead
+// if the false positive rate per shingle (occupancy ^ DV) stays <= SPARSE_MAX_FP (occupancy <= 0.42 for DV 8)
+#define LLC_SIZE  (32ULL << 20)		// last level cache [bytes]
+#define SPARSE_MAX_FP  0.001
 
 // scatter_v1: diversified fingerprint bases
 // -----------------------------------------
-// 1 cache-line	 ( 64 bytes)
-const uint64_t B_DIV[DV]= {257, 263, 269, 271, 277, 281, 283, 293};
+// 1 cache-line	 ( 64 bytes) per filtering round:
+// round k > 1 re-filters the survivors of round k-1 with a fresh base set (and seed)
+#define MAX_ROUNDS  4
+const uint64_t B_DIV_SET[MAX_ROUNDS][DV]= {
+		{257, 263, 269, 271, 277, 281, 283, 293},
+		{307, 311, 313, 317, 331, 337, 347, 349},
+		{353, 359, 367, 373, 379, 383, 389, 397},
+		{401, 409, 419, 421, 431, 433, 439, 443}};
+#define ROUND  1	// filtering round of the map (1..MAX_ROUNDS), map file suffix "_r<round>" for round > 1
+static_assert(ROUND >= 1 && ROUND <= MAX_ROUNDS, "1 <= ROUND <= MAX_ROUNDS");
+static_assert(!CDC || (ROUND == 1 && GENERATION == 0 && !COUNTING_UPDATE), "chunk file: single map of round 1 scattering s");
+static_assert(CDC_MIN_SIZE >= 64 && CDC_MIN_SIZE < CDC_MAX_SIZE, "64 <= CDC_MIN_SIZE < CDC_MAX_SIZE");
+const uint64_t (&B_DIV)[DV]= B_DIV_SET[ROUND-1];
 
 // C_COM= (B_COM ^ L) % M_COM
 auto c_com= [](){
@@ -107,6 +231,182 @@ auto c_div= [](int id){
 const uint64_t C_DIV[DV]= {c_div(0), c_div(1), c_div(2), c_div(3),
 						   c_div(4), c_div(5), c_div(6), c_div(7)};
 
+// P_COM[k]= (B_COM ^ (L-1-k)) % M_COM	: coefficients of the position-parallel common hashes
+auto p_com= [](){
+		array<uint64_t, L> result;
+		result[L-1]= 1ULL;
+		for (int k = L-2; k >= 0; k--) {
+			result[k]= (result[k+1] * B_COM) % M_COM;
+		}
+		return result;
+};
+const array<uint64_t, L> P_COM= p_com();
+
+// P_DIV[id][k]= (B_DIV[id] ^ (L-1-k)) % M_DIV	: coefficients of the position-parallel diversified hashes
+auto p_div= [](const uint64_t b_div[DV]){
+		array<array<uint64_t, L>, DV> result;
+		for (int id = 0; id < DV; id++) {
+			result[id][L-1]= 1ULL;
+			for (int k = L-2; k >= 0; k--) {
+				result[id][k]= (result[id][k+1] * b_div[id]) % M_DIV;
+			}
+		}
+		return result;
+};
+const array<array<uint64_t, L>, DV> P_DIV= p_div(B_DIV);
+
+// fingerprint families (recorded in the map header)
+// -------------------
+#define FP_RABIN_KARP  0	// Rabin-Karp: polynomial hashes (B_COM, M_COM) and (B_DIV[], M_DIV)
+#define FP_CRC32C      1	// CRC32C of the L-byte window, reduced by multiply-shift
+const char *fp_family_name[]= {"Rabin-Karp", "CRC32C"};
+
+// CRC32C: the window word w is hashed twice, c0= crc(w) and c1= crc(w * CRC_MIX),
+// the premix makes c1 independent of c0 (CRCs with different seeds only differ by a constant)
+#define CRC_SEED  0xFFFFFFFFU
+#define CRC_MIX   0x9E3779B97F4A7C15ULL
+// CRC32C: multiply-shift factors of the diversified hashes (odd)
+const uint32_t A_DIV[DV]= {0x6659FD93, 0x78BD642F, 0xA0B428DB, 0x9C88C6E3, 0x75374CC3, 0xC47D124F, 0x1CE4E5B9, 0x133111EB};
+// CRC32C (Castagnoli, reflected polynomial 0x82F63B78): table of the software fallback
+auto crc_table= [](){
+		array<uint32_t, 256> result;
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) c = (c & 1) ? (c >> 1) ^ 0x82F63B78U : c >> 1;
+			result[i]= c;
+		}
+		return result;
+};
+const array<uint32_t, 256> CRC_TABLE= crc_table();
+
+// content-defined chunking: gear hash g= (g << 1) + GEAR_TABLE[byte], its top bits depend on the last 64 bytes
+auto gear_table= [](){
+		array<uint64_t, 256> result;
+		uint64_t x= 0;
+		for (uint32_t i = 0; i < 256; i++) {
+			uint64_t z= (x+= 0x9E3779B97F4A7C15ULL);
+			z= (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z= (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			result[i]= z ^ (z >> 31);
+		}
+		return result;
+};
+const array<uint64_t, 256> GEAR_TABLE= gear_table();
+
+// shingle sampling (recorded in the map header)
+// ----------------
+// SAMPLE_MINIMIZER: of every window of LT= LP-L+1 consecutive shingles (a substring of length LP)
+// only the minimizer is inserted (scatter) and probed (gather). A common substring of length
+// >= LP has the same minimizer in s and S, thus no common substring is lost, while map fill
+// and probe volume drop to the minimizer density ~ 2 / (LT+1).
+#define SAMPLE_ALL        0	// every shingle
+#define SAMPLE_MINIMIZER  1	// window minimizers
+const char *sampling_name[]= {"all shingles", "window minimizers"};
+#define LT  (LP - L + 1)	// window [shingles] (run threshold)
+// minimizer order: mixed common hash (the plain minimum would crowd the low map addresses)
+#define MINIMIZER_KEY(com)  ((uint32_t)((com) * 0x9E3779B1U))
+// sliding window of the last LT shingles (carried across batches)
+struct minimizer_window {
+	uint64_t position[LT];		// shingle offset
+	uint32_t key[LT];			// MINIMIZER_KEY of the common hash
+	com_t    com[LT];			// common hash
+	uint8_t  div[LT][DV];		// diversified hashes
+	uint64_t seen= 0;			// number of shingles pushed
+	uint64_t last= ~0ULL;		// offset of the last minimizer
+};
+// push a shingle, returns true when the window is complete; m: ring index of the minimizer
+inline bool push_window(minimizer_window &mw, uint64_t position, com_t com, const uint8_t div_hash[][BATCH_SIZE], uint32_t j, uint32_t &m) {
+	uint32_t r= mw.seen % LT;
+	mw.position[r]= position;
+	mw.key[r]= MINIMIZER_KEY(com);
+	mw.com[r]= com;
+	for (uint8_t id= 0; id < DV; id++) mw.div[r][id]= div_hash[id][j];
+	if (++mw.seen < LT) return(false);
+	// leftmost minimum, scanning from the oldest shingle
+	m= mw.seen % LT;
+	for (uint32_t k= 1; k < LT; k++) {
+		uint32_t q= (mw.seen + k) % LT;
+		if (mw.key[q] < mw.key[m]) m= q;
+	}
+	return(true);
+}
+
+// map file header
+// ---------------
+#define MAP_MAGIC  0x31465343U	// "CSF1"
+struct map_header {
+	time_t   setup_time;		// map setup time (seed of the cyclic permutations)
+	uint32_t magic;				// MAP_MAGIC
+	uint32_t fp_family;			// fingerprint family (FP_RABIN_KARP, FP_CRC32C)
+	uint64_t m_com;				// modulus of the common hashes
+	uint64_t m_div;				// modulus of the diversified hashes
+	uint32_t sampling;			// shingle sampling (SAMPLE_ALL, SAMPLE_MINIMIZER)
+	uint32_t window;			// minimizer window [shingles]
+	uint32_t round;				// filtering round (diversified base set B_DIV_SET[round-1])
+	uint32_t engine;			// shingling engine (ENGINE_DIVERSIFIED, ENGINE_PREFIX)
+	uint32_t backend;			// filter backend (BACKEND_BITMAP, BACKEND_BLOOM, BACKEND_XOR)
+	uint32_t bloom_k;			// bits per key of the blocked Bloom filter
+	uint64_t map_size;			// length of the map following the header [bytes]
+	uint64_t filter_seed;		// hash seed of the xor filter
+	uint32_t generation;		// generation of a sliding reference window (0: single map)
+	uint64_t fold;				// folded (sparse) bitmap: modulus of the common hashes (0: not folded)
+};
+
+// filter backends (recorded in the map header)
+// ---------------
+// scatter builds and gather queries the set of the reference shingle fingerprints (com, div[DV]):
+// BACKEND_BITMAP: DV cofilters of 1 bit per slot (com + div[id]), DV map reads per query
+// BACKEND_BLOOM : register-blocked Bloom filter, BLOOM_K bits in one 64 bit block, 1 map read per query
+// BACKEND_XOR   : static xor filter of 8 bit fingerprints, 3 map reads per query
+//                 (built at the end of scatter from the complete key set: ~ 40 bytes per key while building)
+// BACKEND_COUNTING: counting map, the DV cofilters of a slot packed as 4 bit counters in one uint32,
+//                 reference ranges can be added and removed, compacted to the bitmap (DV map reads per query)
+#define BACKEND_BITMAP    0
+#define BACKEND_BLOOM     1
+#define BACKEND_XOR       2
+#define BACKEND_COUNTING  3
+const char *backend_name[]= {"bitmap (DV cofilters)", "blocked Bloom filter", "xor filter", "counting map"};
+const uint32_t backend_reads[]= {DV, 1, 3, DV};	// map reads per query
+#define COUNTER_MAX  15		// saturated 4 bit counter (sticky: never decremented)
+#define BLOOM_K  6			// bits per key of the blocked Bloom filter
+
+// 64 bit key of the shingle fingerprint (com, div[DV])
+inline uint64_t shingle_key(com_t com, const uint8_t d[DV]) {
+	uint64_t w;
+	memcpy(&w, d, 8);		// DV == 8 diversified hashes
+	uint64_t x= ((uint64_t)com << 32 | (uint64_t)com >> 32) ^ (w * 0x9E3779B97F4A7C15ULL);
+	// murmur3 finalizer
+	x^= x >> 33; x*= 0xFF51AFD7ED558CCDULL;
+	x^= x >> 33; x*= 0xC4CEB9FE1A85EC53ULL;
+	x^= x >> 33;
+	return(x);
+}
+// blocked Bloom filter: block of the key (blocks < 2^32) and its BLOOM_K bits
+inline uint64_t bloom_block(uint64_t key, uint64_t blocks) {
+	return(((key >> 32) * blocks) >> 32);
+}
+inline uint64_t bloom_mask(uint64_t key) {
+	uint64_t y= key * 0x9E3779B97F4A7C15ULL;
+	uint64_t mask= 0;
+	for (uint32_t i= 0; i < BLOOM_K; i++) mask|= 1ULL << ((y >> (58 - 6*i)) & 63);
+	return(mask);
+}
+// xor filter: hash of the key, its slot in segment i (of 3) and its fingerprint
+inline uint64_t xor_hash(uint64_t key, uint64_t seed) {
+	uint64_t x= key + seed;
+	x^= x >> 33; x*= 0xFF51AFD7ED558CCDULL;
+	x^= x >> 33; x*= 0xC4CEB9FE1A85EC53ULL;
+	x^= x >> 33;
+	return(x);
+}
+inline uint64_t xor_slot(uint64_t h, uint32_t i, uint64_t segment) {
+	uint64_t r= (i == 0) ? h : (h << (21*i)) | (h >> (64 - 21*i));
+	return(i * segment + (((r & 0xFFFFFFFFULL) * segment) >> 32));
+}
+inline uint8_t xor_fingerprint(uint64_t h) {
+	return((uint8_t)(h ^ (h >> 32)));
+}
+
 // THREADS (1,2,3) working on three containers (A,B,C)
 // =======
 // WORKER 1 : read input
@@ -121,7 +421,7 @@ double worker1_waiting_time;
 // WORKER 2 : produce hash
 void worker2_thread();
 // hash the shingles of the batch
-void hash_batch(uint8_t s[], uint32_t hash_count, uint64_t com_hash[], uint8_t div_hash[]);
+void hash_batch(uint8_t s[], uint32_t hash_count, com_t com_hash[], uint8_t div_hash[][BATCH_SIZE]);
 mutex mx2;
 condition_variable cv2;
 bool cv2_scheduler_enabled= false;
@@ -131,6 +431,7 @@ double worker2_waiting_time;
 // WORKER 3 : consume hash
 void worker3_thread();
 // record in the hash map the hash values of the batch
+void record_batch(uint32_t j0, uint32_t hash_count, com_t com_hash[], uint8_t div_hash[][BATCH_SIZE]);
 mutex mx3;
 condition_variable cv3;
 bool cv3_scheduler_enabled= false;
@@ -138,28 +439,124 @@ bool cv3_worker3_enabled= false;
 double worker3_process_time;
 double worker3_waiting_time;
 
+// PROGRESS COUNTERS
+// =================
+// written once per batch by their worker (single writer: relaxed load + store, no locked instruction),
+// read by the reporter thread (relaxed: no synchronization with the hot loops)
+alignas(64) atomic<uint64_t> progress_bytes(0);		// worker1: bytes read
+alignas(64) atomic<uint64_t> progress_hashed(0);	// worker2: shingles hashed
+alignas(64) atomic<uint64_t> progress_inserted(0);	// worker3: shingles inserted into the map
+atomic<bool> progress_stop(false);
+inline void progress_add(atomic<uint64_t> &counter, uint64_t x) {
+	counter.store(counter.load(memory_order_relaxed) + x, memory_order_relaxed);
+}
+void progress_thread(uint64_t total_bytes);
+
+// TRACE RING BUFFERS
+// ==================
+// one ring per thread (0: scheduler, 1..3: worker1..3), written by its thread only, read after the join
+#define TRACE_SIGNAL   0	// scheduler: start-signals sent to the workers
+#define TRACE_STAGE    1	// scheduler: waiting for the end-signals of the stage
+#define TRACE_WAIT     2	// worker: waiting for the start-signal
+#define TRACE_PROCESS  3	// worker: processing a container
+const char *trace_kind_name[]= {"signal", "stage", "wait", "process"};
+struct trace_event {
+	double begin;			// [microseconds] since trace_epoch
+	float duration;			// [microseconds]
+	uint32_t id;			// batch_id (worker), stage_id (scheduler)
+	uint8_t kind;
+	char container;			// 'A', 'B', 'C' (scheduler: ' ')
+};
+struct trace_ring {
+	trace_event events[TRACE ? TRACE_EVENTS : 1];
+	uint64_t count;			// events recorded
+};
+trace_ring trace_rings[4];
+Time trace_epoch;
+inline void trace(uint32_t tid, uint8_t kind, char container, uint32_t id, Time begin) {
+	if (!TRACE) return;
+	Time end= start_timer();
+	trace_ring &ring= trace_rings[tid];
+	trace_event &e= ring.events[ring.count++ % TRACE_EVENTS];
+	e.begin= chrono::duration<double, micro>(begin - trace_epoch).count();
+	e.duration= chrono::duration<float, micro>(end - begin).count();
+	e.id= id;
+	e.kind= kind;
+	e.container= container;
+}
+uint64_t write_trace();
+
 // CONTAINERS (A,B,C)
 // ==================
+// hash batches are aligned structures of arrays: 32 bit common hashes and
+// DV lanes of diversified hashes, streamed lane by lane by producer and consumer
+static_assert(BACKEND != BACKEND_COUNTING || SAMPLING == SAMPLE_ALL, "the counting map records all shingles");
+static_assert(GENERATION == 0 || BACKEND == BACKEND_BITMAP, "generations are combined bitmaps");
 // CONTAINER A
 bool ctr_A_busy= false;					// true: container A busy (a worker is processing its contents)
 uint8_t  buf_ctr_A[BATCH_SIZE + LC];	// string buffer: length= buffer size + carry length
-uint64_t com_ctr_A[BATCH_SIZE];			// hash buffer  : common hashes
-uint8_t  div_ctr_A[BATCH_SIZE * DV];	// hash buffer  : diversified hashes (DV number of cofilters)
+alignas(64) com_t    com_ctr_A[BATCH_SIZE];		// hash buffer  : common hashes (com_t)
+alignas(64) uint8_t  div_ctr_A[DV][BATCH_SIZE];	// hash buffer  : diversified hashes (one lane per cofilter)
 // CONTAINER B
 bool ctr_B_busy= false;					// true: container B busy
 uint8_t  buf_ctr_B[BATCH_SIZE + LC];
-uint64_t com_ctr_B[BATCH_SIZE];
-uint8_t  div_ctr_B[BATCH_SIZE * DV];
+alignas(64) com_t    com_ctr_B[BATCH_SIZE];
+alignas(64) uint8_t  div_ctr_B[DV][BATCH_SIZE];
 // CONTAINER C
 bool ctr_C_busy= false;					// true: container C busy
 uint8_t  buf_ctr_C[BATCH_SIZE + LC];
-uint64_t com_ctr_C[BATCH_SIZE];
-uint8_t  div_ctr_C[BATCH_SIZE * DV];
+alignas(64) com_t    com_ctr_C[BATCH_SIZE];
+alignas(64) uint8_t  div_ctr_C[DV][BATCH_SIZE];
 
 // THREAD INTERFACE
 // ================
 // hash map
 uint8_t *map;
+// fingerprint family
+uint32_t fp_family= FP_FAMILY;
+// shingle sampling
+uint32_t sampling= SAMPLING;
+minimizer_window reference_window;	// sliding window over the reference shingles
+uint64_t inserted= 0;				// number of shingles inserted into the map
+// filter backend
+uint32_t backend= BACKEND;
+uint64_t map_size;					// length of the map [bytes]
+uint64_t filter_seed= 0;			// hash seed of the xor filter
+vector<uint64_t> keys;				// xor filter: keys of the reference shingles
+// build the xor filter from the keys
+void build_xor_filter(std::mt19937& mt_rand);
+// counting map: reference byte ranges [begin, end) of the master file added / removed after scattering s
+struct byte_range {
+	uint64_t begin;
+	uint64_t end;
+};
+vector<byte_range> add_ranges= ADD_RANGES;
+vector<byte_range> remove_ranges= REMOVE_RANGES;
+uint64_t removed= 0;				// number of shingles removed from the counting map
+uint64_t underflows= 0;				// shingles to remove but not present (a counter 0), the counters are left unchanged
+// hash the shingles of a master file range and add them to (delta 1) or remove them from (delta -1) the counting map
+void count_range(ifstream &string_input_stream, byte_range range, int delta);
+// load the counting map file, returns the setup time
+time_t load_counting_map(string file_name);
+// content-defined chunks of s
+struct cdc_chunk {
+	uint64_t key;		// chunk hash
+	uint64_t offset;	// offset in s
+	uint64_t length;	// [bytes]
+};
+struct cdc_state {
+	uint64_t gear= 0;			// gear hash
+	uint64_t start= 0;			// offset of the current chunk
+	uint32_t length= 0;			// bytes of the current chunk (staged in bytes[])
+	uint8_t  bytes[CDC_MAX_SIZE];	// current chunk (its bytes of the previous batches)
+};
+cdc_state reference_chunking;		// worker1
+vector<cdc_chunk> cdc_chunks;		// chunks of s (worker1)
+uint64_t chunk_hash(const uint8_t s[], uint64_t size, uint64_t seed);
+// chunk the bytes of the batch (last: the end of s closes the current chunk)
+void cdc_scan(const uint8_t input_buffer[], uint32_t size, bool last);
+// write the chunks sorted by key, returns the number of chunks
+uint64_t write_chunks(string file_name, time_t setup_time);
 // cyclic permutation vector
 uint8_t shuffle[256];
 
@@ -169,9 +566,18 @@ int main() {
 	uint32_t stage_id;			// current stage
 	uint32_t batch_count;		// total number of required batches (>= 3)
 	// compatible map file: same M_COM, M_DIV and L in scatter and gather!!
+	auto generation_map_file_name= [](uint32_t generation){
+		return map_file_name_prefix
+			+ to_string(M_DIV) + "_"
+			+ to_string(L) + "_g" + to_string(generation) + ".txt";
+	};
 	string map_file_name= map_file_name_prefix
 			+ to_string(M_DIV) + "_"
-			+ to_string(L) + ".txt";
+			+ to_string(L) + (ROUND > 1 ? "_r" + to_string(ROUND) : "") + ".txt";
+	if (GENERATION > 0) map_file_name= generation_map_file_name(GENERATION);
+	string counting_map_file_name= counting_map_file_name_prefix
+			+ to_string(M_DIV) + "_"
+			+ to_string(L) + (ROUND > 1 ? "_r" + to_string(ROUND) : "") + ".txt";
 
 	// total number of batches
 	// -----------------------
@@ -192,6 +598,14 @@ int main() {
 	printf("batch size            : %d \n", BATCH_SIZE);
 	printf("common modulus        : %llu \n", M_COM);
 	printf("diversity modulus     : %llu \n", M_DIV);
+	printf("fingerprint family    : %s \n", fp_family_name[fp_family]);
+	printf("shingle sampling      : %s \n", sampling_name[sampling]);
+	printf("shingling engine      : %s \n", engine_name[ENGINE]);
+	printf("filter backend        : %s \n", backend_name[backend]);
+	printf("filtering round       : %d \n", ROUND);
+	if (GENERATION > 0) {
+		printf("generation            : %d \t(reference offset %llu, %d generations kept) \n", GENERATION, REFERENCE_OFFSET, GENERATIONS_KEPT);
+	}
 	printf("\n");
 	fflush(stdout);
 
@@ -205,15 +619,38 @@ int main() {
 
 	// hash map allocation / reset
 	// ---------------------------
-	map= (uint8_t *)malloc(M_COM + M_DIV); if (map == NULL) exit(11);
-	// reset hash map
-	memset(map, 0b11111111, M_COM + M_DIV);
+	// bitmap: bits cleared by scatter, Bloom filter: bits set by scatter (equal memory: 64 bit blocks),
+	// xor filter: allocated when the keys are complete
+	// counting map: 4 bytes per slot
+	map_size= (backend == BACKEND_BLOOM) ? (M_COM + M_DIV) / 8 * 8 : M_COM + M_DIV;
+	if (backend == BACKEND_COUNTING) map_size= 4 * (M_COM + M_DIV);
+	if (backend != BACKEND_XOR) {
+		map= alloc_map(map_size); if (map == NULL) exit(11);
+		// reset hash map
+		memset(map, (backend == BACKEND_BITMAP) ? 0b11111111 : 0, map_size);
+	}
 
 	// random number initialization with current time
 	// ==============================================
 	//mt19937 mt_rand(123456789);
+	// (update of the counting map: setup time of the counting map file)
 	time_t  cur_time;
-	mt19937 mt_rand(time(&cur_time));
+	// (generation g > 1: shared seed, setup time of generation g-1)
+	if (backend == BACKEND_COUNTING && COUNTING_UPDATE) cur_time= load_counting_map(counting_map_file_name);
+	else if (GENERATION > 1) {
+		map_header previous;
+		ifstream map_input_stream(generation_map_file_name(GENERATION - 1), ios::binary);
+		if (!map_input_stream) {
+			cerr << "Can't open the map file of the previous generation!";
+			exit(26);
+		}
+		map_input_stream.read((char *)&previous, sizeof(map_header));
+		if (previous.magic != MAP_MAGIC || previous.generation != (uint32_t)(GENERATION - 1)) exit(28);
+		map_input_stream.close();
+		cur_time= previous.setup_time;
+	}
+	else time(&cur_time);
+	mt19937 mt_rand(cur_time);
 	//printf("map setup_time :  %s \n", ctime(&cur_time));
 
 	// generate random cyclic permutations: shuffle
@@ -226,6 +663,7 @@ int main() {
 	// elapsed time
 	double elapsed_time= 0;
 	Time start_elapsed_time= start_timer();
+	trace_epoch= start_elapsed_time;
 	// work time
 	double work_time= 0;
 	Time start_work_time;
@@ -236,66 +674,197 @@ int main() {
 	double overhead_time= 0;
 	Time start_overhead_time;
 
-	// start threads (they will wait for the first start-signal)
-	start_overhead_time= start_timer();
-    thread worker1(worker1_thread);
-    thread worker2(worker2_thread);
-    thread worker3(worker3_thread);
-    overhead_time+= get_elapsed_time(start_overhead_time);
-
-    // first stage: 1A (worker1 processes container A)
-	{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
-	{unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_scheduler_enabled;}); cv1_scheduler_enabled= false;}
-	// second stage: 1B, 2A
-	{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
-	{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
-	{unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_scheduler_enabled;}); cv1_scheduler_enabled= false;}
-	{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_scheduler_enabled;}); cv2_scheduler_enabled= false;}
-	// third stage: 1C, 2B, 3A
-	// etc...
-	for (stage_id= 3; stage_id <= batch_count; stage_id++) {
-		//p cout << "send start-signal to workers \n"; fflush(stdout);
-		// <== send start-signal to workers
-		start_schedule_time= start_timer();
+	if (!(backend == BACKEND_COUNTING && COUNTING_UPDATE)) {
+		// start threads (they will wait for the first start-signal)
+		start_overhead_time= start_timer();
+	    thread worker1(worker1_thread);
+	    thread worker2(worker2_thread);
+	    thread worker3(worker3_thread);
+	    thread reporter;
+	    if (PROGRESS_MS > 0) reporter= thread(progress_thread, ns);
+	    overhead_time+= get_elapsed_time(start_overhead_time);
+
+	    // first stage: 1A (worker1 processes container A)
+		{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
+		{unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_scheduler_enabled;}); cv1_scheduler_enabled= false;}
+		// second stage: 1B, 2A
 		{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
 		{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
-		{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
-		schedule_time+= get_elapsed_time(start_schedule_time);
-		//p cout << "wait for end-signals from workers \n"; fflush(stdout);
-		// <== wait for end-signal from workers
-		start_work_time= start_timer();
 		{unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_scheduler_enabled;}); cv1_scheduler_enabled= false;}
 		{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_scheduler_enabled;}); cv2_scheduler_enabled= false;}
+		// third stage: 1C, 2B, 3A
+		// etc...
+		for (stage_id= 3; stage_id <= batch_count; stage_id++) {
+			//p cout << "send start-signal to workers \n"; fflush(stdout);
+			// <== send start-signal to workers
+			start_schedule_time= start_timer();
+			{{lock_guard<mutex> lk(mx1); cv1_worker1_enabled= true;} cv1.notify_one();}
+			{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
+			{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
+			schedule_time+= get_elapsed_time(start_schedule_time);
+			trace(0, TRACE_SIGNAL, ' ', stage_id, start_schedule_time);
+			//p cout << "wait for end-signals from workers \n"; fflush(stdout);
+			// <== wait for end-signal from workers
+			start_work_time= start_timer();
+			{unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_scheduler_enabled;}); cv1_scheduler_enabled= false;}
+			{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_scheduler_enabled;}); cv2_scheduler_enabled= false;}
+			{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
+			work_time+= get_elapsed_time(start_work_time);
+			trace(0, TRACE_STAGE, ' ', stage_id, start_work_time);
+		}
+		// second last stage (batch_count + 1): 2x, 3x
+		{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
+		{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
+		{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_scheduler_enabled;}); cv2_scheduler_enabled= false;}
 		{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
-		work_time+= get_elapsed_time(start_work_time);
-	}
-	// second last stage (batch_count + 1): 2x, 3x
-	{{lock_guard<mutex> lk(mx2); cv2_worker2_enabled= true;} cv2.notify_one();}
-	{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
-	{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_scheduler_enabled;}); cv2_scheduler_enabled= false;}
-	{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
-	// last stage (batch_count + 2): 3y
-	{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
-	{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
-
-	// end threads
-	start_overhead_time= start_timer();
-    worker1.join();
-    worker2.join();
-    worker3.join();
-    overhead_time+= get_elapsed_time(start_overhead_time);
+		// last stage (batch_count + 2): 3y
+		{{lock_guard<mutex> lk(mx3); cv3_worker3_enabled= true;} cv3.notify_one();}
+		{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_scheduler_enabled;}); cv3_scheduler_enabled= false;}
+
+		// end threads
+		start_overhead_time= start_timer();
+	    worker1.join();
+	    worker2.join();
+	    worker3.join();
+	    if (PROGRESS_MS > 0) {
+	    	progress_stop= true;
+	    	reporter.join();
+	    }
+	    overhead_time+= get_elapsed_time(start_overhead_time);
+	}
+	if (backend == BACKEND_XOR) build_xor_filter(mt_rand);
+	if (backend == BACKEND_COUNTING) {
+		// add / remove reference ranges
+		ifstream string_input_stream(master_string_file_name, ios::in|ios::binary);
+		if (!string_input_stream) cerr << "Can't open master file!";
+		for (const byte_range &range : add_ranges) count_range(string_input_stream, range, 1);
+		for (const byte_range &range : remove_ranges) count_range(string_input_stream, range, -1);
+		string_input_stream.close();
+	}
 	elapsed_time= get_elapsed_time(start_elapsed_time);
+	if (TRACE) {
+		uint64_t events= write_trace();
+		printf("trace file            : %s \t(%llu events) \n", trace_file_name.c_str(), events);
+	}
 
 	// result
 	// ======
 	// write hash map to disk
 	// ----------------------
-	ofstream map_output_stream(map_file_name, ios::binary);
-	if (!map_output_stream) cerr << "Can't open map output file!";
-	map_output_stream.write((char *)&cur_time, (int)sizeof(time_t));
-	map_output_stream.write((char *)map, M_COM + M_DIV);
-	map_output_stream.close();
+	uint64_t fold= 0;			// modulus of the folded map (0: not folded)
+	auto write_map= [&](string file_name){
+		map_header header;
+		memset(&header, 0, sizeof(map_header));
+		header.setup_time= cur_time;
+		header.magic= MAP_MAGIC;
+		header.fp_family= fp_family;
+		header.m_com= M_COM;
+		header.m_div= M_DIV;
+		header.sampling= sampling;
+		header.window= LT;
+		header.round= ROUND;
+		header.engine= ENGINE;
+		header.backend= backend;
+		header.bloom_k= BLOOM_K;
+		header.map_size= map_size;
+		header.filter_seed= filter_seed;
+		header.generation= GENERATION;
+		header.fold= fold;
+		ofstream map_output_stream(file_name, ios::binary);
+		if (!map_output_stream) cerr << "Can't open map output file!";
+		map_output_stream.write((char *)&header, sizeof(map_header));
+		map_output_stream.write((char *)map, map_size);
+		map_output_stream.close();
+	};
+	if (backend == BACKEND_COUNTING) {
+		uint64_t saturated= 0;
+		uint32_t *counters= (uint32_t *)map;
+		for (uint64_t i= 0; i < M_COM + M_DIV; i++) {
+			for (uint8_t id= 0; id < DV; id++) saturated+= ((counters[i] >> (4*id)) & 0xF) == COUNTER_MAX;
+		}
+		printf("counting map          : %s \n", counting_map_file_name.c_str());
+		printf(" - added ranges       : %llu \n", (uint64_t)add_ranges.size());
+		printf(" - removed ranges     : %llu \t(%llu shingles, %llu not present) \n", (uint64_t)remove_ranges.size(), removed, underflows);
+		printf(" - saturated counters : %llu \t(sticky, never decremented) \n", saturated);
+		write_map(counting_map_file_name);
+		// compaction: export the bitmap (bit id cleared <=> counter id nonzero)
+		uint8_t *bits= alloc_map(M_COM + M_DIV); if (bits == NULL) exit(11);
+		for (uint64_t i= 0; i < M_COM + M_DIV; i++) {
+			uint8_t w= 0b11111111;
+			for (uint8_t id= 0; id < DV; id++) {
+				if ((counters[i] >> (4*id)) & 0xF) w&= ~(1<<id);
+			}
+			bits[i]= w;
+		}
+		free(map);
+		map= bits;
+		map_size= M_COM + M_DIV;
+		backend= BACKEND_BITMAP;
+	}
+	uint64_t cleared= 0;		// cleared slots of the DV cofilters
+	if (SPARSE_MAP && backend == BACKEND_BITMAP && GENERATION == 0) {
+		// sparse map: fold to the occupancy SPARSE_OCCUPANCY, or to LLC_SIZE within SPARSE_MAX_FP
+		for (uint64_t i= 0; i < M_COM + M_DIV; i++) cleared+= __builtin_popcount((uint8_t)~map[i]);
+		uint64_t modulus= max((uint64_t)((double)cleared / DV / SPARSE_OCCUPANCY), SPARSE_MIN_SIZE);
+		uint64_t llc_modulus= LLC_SIZE - M_DIV;
+		if (modulus > llc_modulus && pow((double)cleared / DV / llc_modulus, DV) <= SPARSE_MAX_FP) modulus= llc_modulus;
+		if (modulus * SPARSE_MIN_FOLD <= M_COM) fold= modulus;
+	}
+	if (fold > 0) {
+		uint8_t *folded= (uint8_t *)malloc(fold + M_DIV); if (folded == NULL) exit(11);
+		memset(folded, 0b11111111, fold);
+		for (uint64_t base= 0; base < M_COM + M_DIV; base+= fold) {
+			uint64_t length= min(fold, (uint64_t)(M_COM + M_DIV - base));
+			for (uint64_t i= 0; i < length; i++) folded[i]&= map[base + i];
+		}
+		memcpy(folded + fold, folded, M_DIV);
+		uint8_t *full_map= map;
+		map= folded;
+		map_size= fold + M_DIV;
+		write_map(map_file_name);
+		map= full_map;
+		map_size= M_COM + M_DIV;
+		free(folded);
+		printf("sparse map folded     : %llu slots per cofilter \t(%llu bytes, 1/%llu of the map) \n", fold, fold + M_DIV, M_COM / fold);
+		printf(" - occupancy          : %11.9f \t(false positive rate %.9f per shingle, %s LLC_SIZE %llu MB) \n",
+				(double)cleared / DV / fold, pow((double)cleared / DV / fold, DV),
+				(fold + M_DIV <= LLC_SIZE) ? "fits" : "exceeds", LLC_SIZE >> 20);
+	} else {
+		write_map(map_file_name);
+	}
 	printf("\nmap setup_time :  %s \n", ctime(&cur_time));
+	if (CDC) {
+		string chunk_file_name= chunk_file_name_prefix + to_string(M_DIV) + "_" + to_string(L) + ".txt";
+		uint64_t chunks= write_chunks(chunk_file_name, cur_time);
+		printf("chunk file            : %s \t(%llu chunks, mean %.0f bytes) \n", chunk_file_name.c_str(), chunks, (double)ns / max(chunks, (uint64_t)1));
+	}
+	if (GENERATION > GENERATIONS_KEPT) {
+		// expired generation
+		remove(generation_map_file_name(GENERATION - GENERATIONS_KEPT).c_str());
+	}
+
+	// map occupancy (fingerprint collisions)
+	// -------------
+	// with ideal fingerprints a slot of a cofilter stays free with probability exp(-n / M_COM),
+	// a lower occupancy than expected indicates collisions among the reference fingerprints
+	uint64_t occupied= 0;
+	printf("inserted shingles     : %llu \t(%6.4f per reference shingle) \n", inserted, (double)inserted / n);
+	if (backend == BACKEND_BITMAP) {
+		for (uint64_t i= 0; i < M_COM + M_DIV; i++) occupied+= __builtin_popcount((uint8_t)~map[i]);
+		printf("map occupancy   (occupied slots / M_COM, mean over the DV cofilters) \n");
+		printf(" - measured     : %11.9f \n", (double)occupied / (DV * M_COM));
+		printf(" - expected     : %11.9f \t(1 - exp(-inserted / M_COM), ideal fingerprints) \n", 1.0 - exp(-(double)inserted / M_COM));
+	} else if (backend == BACKEND_BLOOM) {
+		for (uint64_t i= 0; i < map_size; i++) occupied+= __builtin_popcount(map[i]);
+		printf("map occupancy   (set bits / map bits) \n");
+		printf(" - measured     : %11.9f \n", (double)occupied / (8 * map_size));
+		printf(" - expected     : %11.9f \t(1 - exp(-BLOOM_K * inserted / map bits)) \n", 1.0 - exp(-(double)BLOOM_K * inserted / (8 * map_size)));
+	} else {
+		printf("distinct keys         : %llu \t(xor filter) \n", (uint64_t)keys.size());
+	}
+	printf("map size              : %llu [bytes] \n", map_size);
+	printf("memory per key        : %6.3f [bits] \t(map bits / inserted shingles) \n", 8.0 * map_size / inserted);
+	printf("map reads per query   : %d \n", backend_reads[backend]);
 	// printf("first 20 map values: \n");
 	// for (uint32_t i= 0; i<20; i++) printf(" %d ", map[i]);
 	// printf("\n");
@@ -318,6 +887,8 @@ int main() {
 	printf("worker3     : %9.0f  \n", worker3_waiting_time + worker3_process_time);
     printf(" - wait     : %9.0f  \n", worker3_waiting_time);
     printf(" - process  : %9.0f  \n", worker3_process_time);
+	printf("\n");
+	printf("hashing rate: %6.3f [giga bytes / second] \t(ns / worker2 process time, one core)\n", (float)ns / (1000000.0 * worker2_process_time));
 	fflush(stdout);
 
 }
@@ -326,7 +897,7 @@ int main() {
 
 void worker1_thread()
 {
-	SetThreadAffinityMask(GetCurrentThread(), 7ULL);
+	SetThreadAffinityMask(GetCurrentThread(), AFFINITY_PIPELINE);
 	Time start_time;			// start of time measurement
 	uint8_t *buffer;			// byte string buffer
 	uint8_t *input_buffer;		// start at: buffer + LC (carry length)
@@ -359,7 +930,7 @@ void worker1_thread()
 	// get/check length of master file
 	string_input_stream.seekg (0, string_input_stream.end);
 	// check file size:
-	if ((uint64_t)string_input_stream.tellg() < ns) {
+	if ((uint64_t)string_input_stream.tellg() < REFERENCE_OFFSET + ns) {
 		printf("master file length < ns : %llu \n", ns);
 		fflush(stdout);
 		exit(12);
@@ -369,7 +940,7 @@ void worker1_thread()
 	// set first artificial carry (skipped by worker3 -> first_batch_j0= LC)
 	// ---------------------------------------------------------------------
 	// set position of the input stream at the begin of S0
-	string_input_stream.seekg (0, string_input_stream.beg);
+	string_input_stream.seekg (REFERENCE_OFFSET, string_input_stream.beg);
 	// locate current carry buffer
 	carry_buffer= buf_ctr_C + BATCH_SIZE;
 	// fill carry with dummy values
@@ -387,6 +958,7 @@ void worker1_thread()
 	  start_time= start_timer();
 	  {unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_worker1_enabled;}); cv1_worker1_enabled= false;}
 	  worker1_waiting_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_WAIT, 'A', batch_id, start_time);
 	  start_time= start_timer();
 
 	  //p cout << "worker1 processes container A \n"; fflush(stdout);
@@ -420,6 +992,7 @@ void worker1_thread()
 		  }
 	  }
 //*/
+	  if (CDC) cdc_scan(input_buffer, batch_size, batch_id == batch_count);
 
 	  // this_thread::sleep_for(chrono::milliseconds(200));
 	  //shuffle cout << "worker1 completed container A \n"; fflush(stdout);
@@ -431,6 +1004,8 @@ void worker1_thread()
 	  {lock_guard<mutex> lk(mx1); cv1_scheduler_enabled= true;} cv1.notify_one();
 
 	  worker1_process_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_PROCESS, 'A', batch_id, start_time);
+	  progress_add(progress_bytes, batch_size);
 
 	  if (batch_id == batch_count) {
 		  // the current batch was the last one
@@ -451,6 +1026,7 @@ void worker1_thread()
 	  start_time= start_timer();
 	  {unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_worker1_enabled;}); cv1_worker1_enabled= false;}
 	  worker1_waiting_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_WAIT, 'B', batch_id, start_time);
 	  start_time= start_timer();
 
 	  //p cout << "worker1 processes container B \n"; fflush(stdout);
@@ -484,6 +1060,7 @@ void worker1_thread()
 		  }
 	  }
 //*/
+	  if (CDC) cdc_scan(input_buffer, batch_size, batch_id == batch_count);
 
 	  // this_thread::sleep_for(chrono::milliseconds(200));
 	  //shuffle cout << "worker1 completed container B \n"; fflush(stdout);
@@ -495,6 +1072,8 @@ void worker1_thread()
 	  {lock_guard<mutex> lk(mx1); cv1_scheduler_enabled= true;} cv1.notify_one();
 
 	  worker1_process_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_PROCESS, 'B', batch_id, start_time);
+	  progress_add(progress_bytes, batch_size);
 
 	  if (batch_id == batch_count) {
 		  // the current batch was the last one
@@ -515,6 +1094,7 @@ void worker1_thread()
 	  start_time= start_timer();
 	  {unique_lock<mutex> lk(mx1); cv1.wait(lk, []{return cv1_worker1_enabled;}); cv1_worker1_enabled= false;}
 	  worker1_waiting_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_WAIT, 'C', batch_id, start_time);
 	  start_time= start_timer();
 
 	  //p cout << "worker1 processes container C \n"; fflush(stdout);
@@ -548,6 +1128,7 @@ void worker1_thread()
 		  }
 	  }
 //*/
+	  if (CDC) cdc_scan(input_buffer, batch_size, batch_id == batch_count);
 	  // this_thread::sleep_for(chrono::milliseconds(200));
 	  //p cout << "worker1 completed container C \n"; fflush(stdout);
 	  //p cout << "2C "; fflush(stdout);
@@ -558,6 +1139,8 @@ void worker1_thread()
 	  {lock_guard<mutex> lk(mx1); cv1_scheduler_enabled= true;} cv1.notify_one();
 
 	  worker1_process_time+= get_elapsed_time(start_time);
+	  trace(1, TRACE_PROCESS, 'C', batch_id, start_time);
+	  progress_add(progress_bytes, batch_size);
 
 	  if (batch_id == batch_count) {
 		  // the current batch was the last one
@@ -575,7 +1158,7 @@ void worker1_thread()
 
 void worker2_thread()
 {
-	SetThreadAffinityMask(GetCurrentThread(), 7ULL);
+	SetThreadAffinityMask(GetCurrentThread(), AFFINITY_PIPELINE);
 	Time start_time;			// start of time measurement
 	uint32_t batch_id;			// current batch
 	uint32_t batch_size;		// current batch size
@@ -604,6 +1187,7 @@ void worker2_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_worker2_enabled;}); cv2_worker2_enabled= false;}
 	worker2_waiting_time+= get_elapsed_time(start_time);
+	trace(2, TRACE_WAIT, 'A', batch_id, start_time);
 	start_time= start_timer();
 
 		//p cout << "worker2 processes container A \n"; fflush(stdout);
@@ -623,6 +1207,8 @@ void worker2_thread()
 		{lock_guard<mutex> lk(mx2); cv2_scheduler_enabled= true;} cv2.notify_one();
 
 	worker2_process_time+= get_elapsed_time(start_time);
+	trace(2, TRACE_PROCESS, 'A', batch_id, start_time);
+	progress_add(progress_hashed, batch_size);
 	if (batch_id == batch_count) {
 		// the current batch was the last one
 		cout << "worker2 terminates on A \n"; fflush(stdout);
@@ -642,6 +1228,7 @@ void worker2_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_worker2_enabled;}); cv2_worker2_enabled= false;}
 	worker2_waiting_time+= get_elapsed_time(start_time);
+	trace(2, TRACE_WAIT, 'B', batch_id, start_time);
 	start_time= start_timer();
 
 		//p cout << "worker2 processes container B \n"; fflush(stdout);
@@ -661,6 +1248,8 @@ void worker2_thread()
 		{lock_guard<mutex> lk(mx2); cv2_scheduler_enabled= true;} cv2.notify_one();
 
 	worker2_process_time+= get_elapsed_time(start_time);
+	trace(2, TRACE_PROCESS, 'B', batch_id, start_time);
+	progress_add(progress_hashed, batch_size);
 	if (batch_id == batch_count) {
 		// the current batch was the last one
 		cout << "worker2 terminates on B \n"; fflush(stdout);
@@ -680,6 +1269,7 @@ void worker2_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx2); cv2.wait(lk, []{return cv2_worker2_enabled;}); cv2_worker2_enabled= false;}
 	worker2_waiting_time+= get_elapsed_time(start_time);
+	trace(2, TRACE_WAIT, 'C', batch_id, start_time);
 	start_time= start_timer();
 
 		//p cout << "worker2 processes container C \n"; fflush(stdout);
@@ -699,6 +1289,8 @@ void worker2_thread()
 		{lock_guard<mutex> lk(mx2); cv2_scheduler_enabled= true;} cv2.notify_one();
 
 	worker2_process_time+= get_elapsed_time(start_time);
+	trace(2, TRACE_PROCESS, 'C', batch_id, start_time);
+	progress_add(progress_hashed, batch_size);
   if (batch_id == batch_count) {
 	  // the current batch was the last one
 	  cout << "worker2 terminates on C \n"; fflush(stdout);
@@ -716,7 +1308,7 @@ void worker2_thread()
 
 void worker3_thread()
 {
-	SetThreadAffinityMask(GetCurrentThread(), 8ULL);
+	SetThreadAffinityMask(GetCurrentThread(), AFFINITY_PROBE);
 	Time start_time;			// start of time measurement
 	uint32_t batch_id;			// current batch
 	uint32_t first_batch_j0= LC;// skip first (artificial) carry  <-------------
@@ -746,6 +1338,7 @@ void worker3_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_worker3_enabled;}); cv3_worker3_enabled= false;}
 	worker3_waiting_time+= get_elapsed_time(start_time);
+	trace(3, TRACE_WAIT, 'A', batch_id, start_time);
 	start_time= start_timer();
 
 		//p cout << "worker3 processes container A \n"; fflush(stdout);
@@ -754,18 +1347,8 @@ void worker3_thread()
 		// ***********************************************************
 		// worker3 produces/processes the current batch in container A
 		// ***********************************************************
-		// record in the hash map the hash values of the shingle j
-		for (uint32_t j= first_batch_j0; j < batch_size; j++) {
-			// if it doesnt help, it doesnt hurt?
-			for (uint64_t i= 0; i < ((M_DIV + 32) / 64); i++) {
-				__builtin_prefetch (&com_ctr_A[j] + i * 64, 1, 3);
-			}
-			// keep track of the hash occurrence (TIME CRITICAL)
-			for (uint8_t id= 0; id < DV; id++) {
-				// ClearBit
-				map[com_ctr_A[j] + div_ctr_A[j*DV+id]] &= ~(1<<id);
-			}
-		}
+		// record in the hash map the hash values of the batch
+		record_batch(first_batch_j0, batch_size, com_ctr_A, div_ctr_A);
 		// skip only the first (artificial) carry
 		first_batch_j0= 0;
 
@@ -779,6 +1362,8 @@ void worker3_thread()
 		{lock_guard<mutex> lk(mx3); cv3_scheduler_enabled= true;} cv3.notify_one();
 
 	worker3_process_time+= get_elapsed_time(start_time);
+	trace(3, TRACE_PROCESS, 'A', batch_id, start_time);
+	progress_inserted.store(inserted, memory_order_relaxed);
 	if (batch_id == batch_count) {
 		// the current batch was the last one
 		cout << "worker3 terminates on A \n"; fflush(stdout);
@@ -798,6 +1383,7 @@ void worker3_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_worker3_enabled;}); cv3_worker3_enabled= false;}
 	worker3_waiting_time+= get_elapsed_time(start_time);
+	trace(3, TRACE_WAIT, 'B', batch_id, start_time);
 	start_time= start_timer();
 
 		//p cout << "worker3 processes container B \n"; fflush(stdout);
@@ -806,18 +1392,8 @@ void worker3_thread()
 		// ***********************************************************
 		// worker3 produces/processes the current batch in container B
 		// ***********************************************************
-		// record in the hash map the hash values of the shingle j
-		for (uint32_t j= 0; j < batch_size; j++) {
-			// if it doesnt help, it doesnt hurt?
-			for (uint64_t i= 0; i < ((M_DIV + 32) / 64); i++) {
-				__builtin_prefetch (&com_ctr_B[j] + i * 64, 1, 3);
-			}
-			// keep track of the hash occurrence (TIME CRITICAL)
-			for (uint8_t id= 0; id < DV; id++) {
-				// ClearBit
-				map[com_ctr_B[j] + div_ctr_B[j*DV+id]] &= ~(1<<id);
-			}
-		}
+		// record in the hash map the hash values of the batch
+		record_batch(0, batch_size, com_ctr_B, div_ctr_B);
 
 		// this_thread::sleep_for(chrono::milliseconds(300));
 		//p cout << "worker3 completed container B \n"; fflush(stdout);
@@ -829,6 +1405,8 @@ void worker3_thread()
 		{lock_guard<mutex> lk(mx3); cv3_scheduler_enabled= true;} cv3.notify_one();
 
 	worker3_process_time+= get_elapsed_time(start_time);
+	trace(3, TRACE_PROCESS, 'B', batch_id, start_time);
+	progress_inserted.store(inserted, memory_order_relaxed);
 	if (batch_id == batch_count) {
 		// the current batch was the last one
 		cout << "worker3 terminates on B \n"; fflush(stdout);
@@ -848,6 +1426,7 @@ void worker3_thread()
 	start_time= start_timer();
 	{unique_lock<mutex> lk(mx3); cv3.wait(lk, []{return cv3_worker3_enabled;}); cv3_worker3_enabled= false;}
 	worker3_waiting_time+= get_elapsed_time(start_time);
+	trace(3, TRACE_WAIT, 'C', batch_id, start_time);
 	start_time= start_timer();
 
 		//p cout << "worker3 processes container C \n"; fflush(stdout);
@@ -856,18 +1435,8 @@ void worker3_thread()
 		// ***********************************************************
 		// worker3 produces/processes the current batch in container C
 		// ***********************************************************
-		// record in the hash map the hash values of the shingle j
-		for (uint32_t j= 0; j < batch_size; j++) {
-			// if it doesnt help, it doesnt hurt?
-			for (uint64_t i= 0; i < ((M_DIV + 32) / 64); i++) {
-				__builtin_prefetch (&com_ctr_C[j] + i * 64, 1, 3);
-			}
-			// keep track of the hash occurrence (TIME CRITICAL)
-			for (uint8_t id= 0; id < DV; id++) {
-				// ClearBit
-				map[com_ctr_C[j] + div_ctr_C[j*DV+id]] &= ~(1<<id);
-			}
-		}
+		// record in the hash map the hash values of the batch
+		record_batch(0, batch_size, com_ctr_C, div_ctr_C);
 
 		// this_thread::sleep_for(chrono::milliseconds(300));
 		//p cout << "worker3 completed container C \n"; fflush(stdout);
@@ -879,6 +1448,8 @@ void worker3_thread()
 		{lock_guard<mutex> lk(mx3); cv3_scheduler_enabled= true;} cv3.notify_one();
 
 	worker3_process_time+= get_elapsed_time(start_time);
+	trace(3, TRACE_PROCESS, 'C', batch_id, start_time);
+	progress_inserted.store(inserted, memory_order_relaxed);
 	if (batch_id == batch_count) {
 		// the current batch was the last one
 		cout << "worker3 terminates on C \n"; fflush(stdout);
@@ -896,52 +1467,461 @@ void worker3_thread()
 
 // ****************************************************************************************************************************
 
-inline void update_div_hashes(uint8_t hash[], uint8_t hash1[], const uint8_t s[]) {
-	for (uint8_t id= 0; id < DV; id++) {
-		hash1[id]= hash[id]= (256*M_DIV + s[L]  +  hash[id] * B_DIV[id]  -  C_DIV[id] * s[0]) % M_DIV;
+inline void record_shingle(com_t com, const uint8_t d[DV]) {
+	// record a shingle in the Bloom filter or collect its key for the xor filter
+	uint64_t key= shingle_key(com, d);
+	if (backend == BACKEND_BLOOM) {
+		uint64_t *block= (uint64_t *)map + bloom_block(key, map_size / 8);
+		*block|= bloom_mask(key);
+	} else {
+		keys.push_back(key);
 	}
 }
 
-void hash_batch(
+void record_batch(
+	uint32_t j0,			// input : first hash to record
+	uint32_t hash_count,	// input : number of hashes
+	com_t com_hash[],	// input : batch of hash_count common hashes
+	uint8_t  div_hash[][BATCH_SIZE]) // input : DV lanes of hash_count diversified hashes
+{
+	// uint8_t  map[],		// output: hash map (global)
+	if (sampling == SAMPLE_MINIMIZER) {
+		// record the window minimizers only
+		uint32_t m;
+		for (uint32_t j= j0; j < hash_count; j++) {
+			if (!push_window(reference_window, reference_window.seen, com_hash[j], div_hash, j, m)) continue;
+			if (reference_window.position[m] == reference_window.last) continue;
+			reference_window.last= reference_window.position[m];
+			if (backend == BACKEND_BITMAP) {
+				for (uint8_t id= 0; id < DV; id++) {
+					// ClearBit
+					map[reference_window.com[m] + reference_window.div[m][id]] &= ~(1<<id);
+				}
+			} else {
+				record_shingle(reference_window.com[m], reference_window.div[m]);
+			}
+			inserted++;
+		}
+		return;
+	}
+	inserted+= hash_count - j0;
+	if (backend == BACKEND_COUNTING) {
+		uint32_t *counters= (uint32_t *)map;
+		for (uint32_t j= j0; j < hash_count; j++) {
+			for (uint8_t id= 0; id < DV; id++) {
+				// saturating increment of counter id
+				uint32_t &w= counters[com_hash[j] + div_hash[id][j]];
+				if (((w >> (4*id)) & 0xF) != COUNTER_MAX) w+= 1U << (4*id);
+			}
+		}
+		return;
+	}
+	if (backend != BACKEND_BITMAP) {
+		uint8_t d[DV];
+		for (uint32_t j= j0; j < hash_count; j++) {
+			for (uint8_t id= 0; id < DV; id++) d[id]= div_hash[id][j];
+			record_shingle(com_hash[j], d);
+		}
+		return;
+	}
+	// record in the hash map the hash values of the shingle j
+	for (uint32_t j= j0; j < hash_count; j++) {
+		// prefetch the slots of the shingle PREFETCH_DISTANCE ahead (com .. com + M_DIV-1: up to 2 cache lines)
+		if (PREFETCH_DISTANCE > 0 && j + PREFETCH_DISTANCE < hash_count) {
+			__builtin_prefetch (&map[com_hash[j + PREFETCH_DISTANCE]], 1, 3);
+			__builtin_prefetch (&map[com_hash[j + PREFETCH_DISTANCE] + M_DIV - 1], 1, 3);
+		}
+		// keep track of the hash occurrence (TIME CRITICAL)
+		for (uint8_t id= 0; id < DV; id++) {
+			// ClearBit
+			map[com_hash[j] + div_hash[id][j]] &= ~(1<<id);
+		}
+	}
+}
+
+//	*********************************************************************************************************************************************
+
+// position-parallel hashing
+// -------------------------
+// Because L is short, each fingerprint is evaluated directly as an L-term dot product
+// of the shingle bytes with the powers of the base, reduced only once (lazy reduction):
+//   com_hash[j]=       (s[j]*P_COM[0]     + ... + s[j+L-1]*P_COM[L-1])     % M_COM
+//   div_hash[id][j]=   (s[j]*P_DIV[id][0] + ... + s[j+L-1]*P_DIV[id][L-1]) % M_DIV
+// The positions j are independent (no loop carried dependency) and the result is
+// bit-identical to the rolling recurrence.
+// AVX2: common hashes      4 positions per register (exact in double precision: < 2^53)
+//       diversified hashes 8 positions per register and cofilter lane (exact in float: < 2^24)
+
+void rk_hash_batch(
 	uint8_t  s[], 			// input : current string buffer
 	uint32_t hash_count, 	// input : number of hashes
-	uint64_t com_hash[], 	// output: batch of (hash_count)      common hashes
-	uint8_t  div_hash[]) 	// output: batch of (hash_count * DV) diversified hashes
+	com_t com_hash[], 	// output: batch of (hash_count) common hashes
+	uint8_t  div_hash[][BATCH_SIZE]) // output: DV lanes of (hash_count) diversified hashes
 {
 	// produce batch of hashes (common & diversified)
 	// for the shingles in the current input buffer s
+	uint32_t j_com= 0;		// first common hash left to the scalar loop
+	uint32_t j_div= 0;		// first diversified hash left to the scalar loop
+
+#ifdef __AVX2__
+#if !WIDE_MAP
+	// compute common hashes (4 positions in parallel)
+	// ---------------------
+	const __m256d m_com= _mm256_set1_pd((double)M_COM);
+	const __m256d m_inv= _mm256_set1_pd(1.0 / (double)M_COM);
+	const __m256d zero=  _mm256_setzero_pd();
+	__m256d p_com[L];
+	for (uint32_t k= 0; k < L; k++) p_com[k]= _mm256_set1_pd((double)P_COM[k]);
+	for (; j_com + 4 <= hash_count; j_com+= 4) {
+		__m256d h= zero;
+		for (uint32_t k= 0; k < L; k++) {
+			uint32_t b;
+			memcpy(&b, s + j_com + k, 4);
+			__m256d v= _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(b)));
+			h= _mm256_add_pd(h, _mm256_mul_pd(v, p_com[k]));
+		}
+		// lazy reduction: the quotient is exact or off by one
+		__m256d q= _mm256_round_pd(_mm256_mul_pd(h, m_inv), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+		__m256d r= _mm256_sub_pd(h, _mm256_mul_pd(q, m_com));
+		r= _mm256_add_pd(r, _mm256_and_pd(_mm256_cmp_pd(r, zero, _CMP_LT_OQ), m_com));
+		r= _mm256_sub_pd(r, _mm256_and_pd(_mm256_cmp_pd(r, m_com, _CMP_GE_OQ), m_com));
+		_mm_storeu_si128((__m128i *)&com_hash[j_com], _mm256_cvttpd_epi32(r));
+	}
+#endif
 
-	// compute diversified hashes
+	// compute diversified hashes (8 positions in parallel)
 	// --------------------------
-	// compute the hashes of the first, leftmost shingles
+	// byte pairs (s[j+k], s[j+k+1]) times coefficient pairs: _mm256_madd_epi16
+	const __m256  d_inv= _mm256_set1_ps(1.0f / (float)M_DIV);
+	const __m256i d_mod= _mm256_set1_epi32((int)M_DIV);
+	const __m256i d_max= _mm256_set1_epi32((int)M_DIV - 1);
+	// dword order after packing: cofilter (0,1,2,3 | 4,5,6,7) x positions (0-3 | 4-7) -> 8 positions per cofilter
+	const __m256i d_ord= _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	__m256i p_div[DV][(L+1)/2];
 	for (uint8_t id= 0; id < DV; id++) {
-		div_hash[id]= 0;
-		for (uint32_t j= 0; j < L; j++) {
-			div_hash[id]= (div_hash[id] * B_DIV[id] + s[j]) % M_DIV;
+		for (uint32_t k= 0; k < L; k+= 2) {
+			uint32_t c= P_DIV[id][k] | ((k+1 < L) ? P_DIV[id][k+1] << 16 : 0);
+			p_div[id][k/2]= _mm256_set1_epi32((int)c);
 		}
-		div_hash[DV+id]= div_hash[id];
 	}
-	// compute the hashes of the following shingles (rolling forward)
-	// note: j= 1!
-	for (uint32_t j= 1; j < hash_count; j++) {
-		update_div_hashes(&div_hash[j*DV], &div_hash[(j+1)*DV], s+j-1);
+	for (; j_div + 8 <= hash_count; j_div+= 8) {
+		__m256i w[(L+1)/2];
+		for (uint32_t k= 0; k < L; k+= 2) {
+			uint64_t b;
+			memcpy(&b, s + j_div + k, 8);
+			w[k/2]= _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(b));
+			if (k+1 < L) {
+				memcpy(&b, s + j_div + k + 1, 8);
+				w[k/2]= _mm256_or_si256(w[k/2], _mm256_slli_epi32(_mm256_cvtepu8_epi32(_mm_cvtsi64_si128(b)), 16));
+			}
+		}
+		__m256i r[DV];
+		for (uint8_t id= 0; id < DV; id++) {
+			__m256i h= _mm256_madd_epi16(w[0], p_div[id][0]);
+			for (uint32_t k= 1; k < (L+1)/2; k++) {
+				h= _mm256_add_epi32(h, _mm256_madd_epi16(w[k], p_div[id][k]));
+			}
+			// lazy reduction: the quotient is exact or one too small
+			__m256i q= _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(h), d_inv));
+			r[id]= _mm256_sub_epi32(h, _mm256_mullo_epi32(q, d_mod));
+			r[id]= _mm256_sub_epi32(r[id], _mm256_and_si256(_mm256_cmpgt_epi32(r[id], d_max), d_mod));
+		}
+		// pack to bytes: 8 positions of each cofilter lane
+		for (uint8_t id= 0; id < DV; id+= 4) {
+			__m256i x= _mm256_permutevar8x32_epi32(_mm256_packus_epi16(
+					_mm256_packus_epi32(r[id], r[id+1]), _mm256_packus_epi32(r[id+2], r[id+3])), d_ord);
+			__m128i lo= _mm256_castsi256_si128(x);
+			__m128i hi= _mm256_extracti128_si256(x, 1);
+			_mm_storel_epi64((__m128i *)&div_hash[id  ][j_div], lo);
+			_mm_storel_epi64((__m128i *)&div_hash[id+1][j_div], _mm_unpackhi_epi64(lo, lo));
+			_mm_storel_epi64((__m128i *)&div_hash[id+2][j_div], hi);
+			_mm_storel_epi64((__m128i *)&div_hash[id+3][j_div], _mm_unpackhi_epi64(hi, hi));
+		}
 	}
+#endif
 
-	// compute common hashes
+	// compute common hashes (remaining positions)
 	// ---------------------
-	// compute the hashes of the first, leftmost shingle
-	com_hash[0]= 0;
-	for (uint32_t j= 0; j < L; j++) {
-		com_hash[0]= (com_hash[0] * B_COM + s[j]) % M_COM;
+	for (uint32_t j= j_com; j < hash_count; j++) {
+		uint64_t h= 0;
+		for (uint32_t k= 0; k < L; k++) h+= s[j+k] * P_COM[k];
+		com_hash[j]= h % M_COM;
+	}
+
+	// compute diversified hashes (remaining positions)
+	// --------------------------
+	for (uint8_t id= 0; id < DV; id++) {
+		for (uint32_t j= j_div; j < hash_count; j++) {
+			uint32_t h= 0;
+			for (uint32_t k= 0; k < L; k++) h+= s[j+k] * (uint32_t)P_DIV[id][k];
+			div_hash[id][j]= h % M_DIV;
+		}
+	}
+}
+
+// CRC32C fingerprints
+// -------------------
+// per shingle: c0= crc(w), c1= crc(w * CRC_MIX) over the L-byte window w (8 bytes per step)
+//   com_hash[j]=       (c0 * M_COM) >> 32
+//   div_hash[id][j]=   ((((c1 * A_DIV[id]) mod 2^32) >> 16) * M_DIV) >> 16
+// The hardware instruction (SSE4.2) hashes 8 bytes per cycle, no divisions are left.
+
+inline uint64_t load_window(const uint8_t s[], uint32_t len) {
+	// little endian word of the len (<= 8) bytes at s, without reading beyond s[len-1]
+	// (composed from aligned-size loads: a single narrow memcpy would stall on store forwarding)
+	uint64_t w= 0;
+	uint32_t k= 0;
+	if (len == 8) {memcpy(&w, s, 8); return(w);}
+	if (len - k >= 4) {uint32_t v; memcpy(&v, s + k, 4); w|= (uint64_t)v << (8*k); k+= 4;}
+	if (len - k >= 2) {uint16_t v; memcpy(&v, s + k, 2); w|= (uint64_t)v << (8*k); k+= 2;}
+	if (len - k >= 1) {w|= (uint64_t)s[k] << (8*k);}
+	return(w);
+}
+
+inline uint32_t crc32c_u64(uint32_t crc, uint64_t w) {
+#ifdef __SSE4_2__
+	return (uint32_t)_mm_crc32_u64(crc, w);
+#else
+	for (int k= 0; k < 8; k++) {
+		crc= CRC_TABLE[(crc ^ w) & 0xFF] ^ (crc >> 8);
+		w>>= 8;
 	}
-	// compute the hashes of the following shingles in the buffer
+	return crc;
+#endif
+}
+
+void crc_hash_batch(
+	uint8_t  s[], 			// input : current string buffer
+	uint32_t hash_count, 	// input : number of hashes
+	com_t com_hash[], 	// output: batch of (hash_count) common hashes
+	uint8_t  div_hash[][BATCH_SIZE]) // output: DV lanes of (hash_count) diversified hashes
+{
 	for (uint32_t j= 0; j < hash_count; j++) {
-		com_hash[j+1]= ((com_hash[j] + M_COM) * B_COM   -  C_COM * s[j]   +   s[j+L]) % M_COM;
+		uint32_t c0= CRC_SEED;
+		uint32_t c1= CRC_SEED;
+		for (uint32_t k= 0; k < L; k+= 8) {
+			uint64_t w= load_window(s + j + k, (L - k < 8) ? L - k : 8);
+			c0= crc32c_u64(c0, w);
+			c1= crc32c_u64(c1, w * CRC_MIX);
+		}
+		com_hash[j]= ((unsigned __int128)c0 * M_COM) >> 32;
+		for (uint8_t id= 0; id < DV; id++) {
+			div_hash[id][j]= (((c1 * A_DIV[id]) >> 16) * (uint32_t)M_DIV) >> 16;
+		}
 	}
 }
 
+void hash_batch(
+	uint8_t  s[], 			// input : current string buffer
+	uint32_t hash_count, 	// input : number of hashes
+	com_t com_hash[], 	// output: batch of (hash_count) common hashes
+	uint8_t  div_hash[][BATCH_SIZE]) // output: DV lanes of (hash_count) diversified hashes
+{
+	// fingerprint family of the map
+	if (fp_family == FP_CRC32C) crc_hash_batch(s, hash_count, com_hash, div_hash);
+	else rk_hash_batch(s, hash_count, com_hash, div_hash);
+}
+
 //	*********************************************************************************************************************************************
 
+void count_range(
+	ifstream &string_input_stream,	// input : master file
+	byte_range range,				// input : bytes [begin, end) of the master file
+	int delta)						// input : 1 add, -1 remove
+{
+	// the range is read, shuffled and hashed batch-wise in container A (the workers have terminated)
+	// output: map (global counting map)
+	uint32_t *counters= (uint32_t *)map;
+	uint64_t demo_offset= REFERENCE_OFFSET + (n / BATCH_SIZE / 2 - 1) * BATCH_SIZE;	// "Demo-String" (cf. worker1)
+	if (range.end > range.begin + LC) range.end-= LC;	// number of shingles: length - L + 1
+	else return;
+	for (uint64_t begin= range.begin; begin < range.end; begin+= BATCH_SIZE) {
+		uint32_t hash_count= (uint32_t)min(range.end - begin, (uint64_t)BATCH_SIZE);
+		string_input_stream.seekg(begin, string_input_stream.beg);
+		string_input_stream.read((char *)buf_ctr_A, hash_count + LC);
+		if (hash_count + LC != string_input_stream.gcount()) exit(14);
+		for (uint32_t j= 0; j < hash_count + LC; j++) {
+			buf_ctr_A[j]= shuffle[buf_ctr_A[j]];
+			if (begin + j >= demo_offset && begin + j < demo_offset + 20) buf_ctr_A[j]= 0;
+		}
+		hash_batch(buf_ctr_A, hash_count, com_ctr_A, div_ctr_A);
+		if (delta > 0) {
+			record_batch(0, hash_count, com_ctr_A, div_ctr_A);
+			continue;
+		}
+		for (uint32_t j= 0; j < hash_count; j++) {
+			// a shingle with a counter 0 was never added: decrementing its other counters would remove other shingles
+			bool present= true;
+			for (uint8_t id= 0; id < DV && present; id++) present= (counters[com_ctr_A[j] + div_ctr_A[id][j]] >> (4*id)) & 0xF;
+			if (!present) {
+				underflows++;
+				continue;
+			}
+			removed++;
+			for (uint8_t id= 0; id < DV; id++) {
+				uint32_t &w= counters[com_ctr_A[j] + div_ctr_A[id][j]];
+				if (((w >> (4*id)) & 0xF) != COUNTER_MAX) w-= 1U << (4*id);
+			}
+		}
+	}
+}
+
+time_t load_counting_map(string file_name) {
+	// read the counting map (map header + 4 bytes per slot) and return its setup time
+	ifstream map_input_stream(file_name, ios::binary);
+	if (!map_input_stream) {
+		cerr << "Can't open counting map file (input)!";
+		exit(26);
+	}
+	map_header header;
+	map_input_stream.read((char *)&header, sizeof(map_header));
+	if (header.magic != MAP_MAGIC || header.backend != BACKEND_COUNTING || header.map_size != map_size
+			|| header.fp_family != fp_family || header.engine != ENGINE || header.round != ROUND) {
+		printf("incompatible counting map header \n");
+		fflush(stdout);
+		exit(28);
+	}
+	map_input_stream.read((char *)map, map_size);
+	if ((uint64_t)map_input_stream.gcount() != map_size) exit(27);
+	map_input_stream.close();
+	return(header.setup_time);
+}
+
+void build_xor_filter(std::mt19937& mt_rand) {
+	// xor filter (peeling of the 3-partite key hypergraph)
+	// output: map, map_size, filter_seed (global)
+	// distinct keys (a duplicate key would never be peeled)
+	qsort(keys.data(), keys.size(), sizeof(uint64_t), [](const void *a, const void *b) {
+		uint64_t x= *(const uint64_t *)a, y= *(const uint64_t *)b;
+		return((x > y) - (x < y));
+	});
+	uint64_t size= 0;
+	for (uint64_t k= 0; k < keys.size(); k++) {
+		if (size == 0 || keys[k] != keys[size - 1]) keys[size++]= keys[k];
+	}
+	keys.resize(size);
+	uint64_t segment= (32 + (uint64_t)(1.23 * size)) / 3 + 1;	// slots per segment
+	map_size= 3 * segment;
+	vector<uint64_t> mask(map_size);	// xor of the hashes of the keys in the slot
+	vector<uint8_t>  count(map_size);	// number of keys in the slot
+	vector<uint64_t> queue;				// slots of a single key
+	vector<pair<uint64_t, uint64_t>> stack;	// peeling order: hash, slot
+	stack.reserve(size);
+	for (uint32_t attempt= 0; ; attempt++) {
+		if (attempt == 100) {
+			printf("xor filter construction failed \n");
+			exit(29);
+		}
+		filter_seed= ((uint64_t)mt_rand() << 32) | mt_rand();
+		fill(mask.begin(), mask.end(), 0);
+		fill(count.begin(), count.end(), 0);
+		for (uint64_t key : keys) {
+			uint64_t h= xor_hash(key, filter_seed);
+			for (uint32_t i= 0; i < 3; i++) {
+				uint64_t s= xor_slot(h, i, segment);
+				mask[s]^= h;
+				count[s]++;
+			}
+		}
+		queue.clear();
+		for (uint64_t s= 0; s < map_size; s++) if (count[s] == 1) queue.push_back(s);
+		stack.clear();
+		while (!queue.empty()) {
+			uint64_t s= queue.back();
+			queue.pop_back();
+			if (count[s] != 1) continue;
+			uint64_t h= mask[s];
+			stack.push_back({h, s});
+			for (uint32_t i= 0; i < 3; i++) {
+				uint64_t t= xor_slot(h, i, segment);
+				mask[t]^= h;
+				if (--count[t] == 1) queue.push_back(t);
+			}
+		}
+		if (stack.size() == size) break;
+	}
+	// assign the fingerprints in reverse peeling order
+	free(map);
+	map= alloc_map(map_size); if (map == NULL) exit(11);
+	memset(map, 0, map_size);
+	for (uint64_t k= size; k-- > 0; ) {
+		uint64_t h= stack[k].first;
+		map[stack[k].second]= xor_fingerprint(h) ^ map[xor_slot(h, 0, segment)]
+								^ map[xor_slot(h, 1, segment)] ^ map[xor_slot(h, 2, segment)];
+	}
+}
+
+// trace export
+// ------------
+// Chrome trace JSON: one complete event ("ph":"X") per recorded step, one track per thread
+uint64_t write_trace()
+{
+	const char *thread_name[]= {"scheduler", "worker1 (read)", "worker2 (hash)", "worker3 (record)"};
+	uint64_t written= 0;
+	ofstream trace_stream(trace_file_name);
+	if (!trace_stream) {
+		cerr << "Can't open trace file!";
+		return(0);
+	}
+	trace_stream << fixed << setprecision(3);
+	trace_stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	for (uint32_t tid= 0; tid < 4; tid++) {
+		trace_stream << (tid ? ",\n" : "") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+				<< ",\"args\":{\"name\":\"" << thread_name[tid] << "\"}}";
+	}
+	for (uint32_t tid= 0; tid < 4; tid++) {
+		const trace_ring &ring= trace_rings[tid];
+		uint64_t first= (ring.count > TRACE_EVENTS) ? ring.count - TRACE_EVENTS : 0;
+		for (uint64_t k= first; k < ring.count; k++) {
+			const trace_event &e= ring.events[k % TRACE_EVENTS];
+			trace_stream << ",\n{\"name\":\"" << trace_kind_name[e.kind];
+			if (e.container != ' ') trace_stream << " " << e.container;
+			trace_stream << "\",\"cat\":\"" << thread_name[tid] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+					<< ",\"ts\":" << e.begin << ",\"dur\":" << e.duration
+					<< ",\"args\":{\"" << (tid ? "batch" : "stage") << "\":" << e.id << "}}";
+			written++;
+		}
+	}
+	trace_stream << "\n]}\n";
+	trace_stream.close();
+	return(written);
+}
+
+// progress reporter
+// -----------------
+// samples the stage counters every PROGRESS_MS: MB/s of the last interval and of the run, ETA
+void progress_thread(uint64_t total_bytes)
+{
+	ofstream metrics_stream;
+	if (METRICS_FILE) {
+		metrics_stream.open(metrics_file_name);
+		if (!metrics_stream) cerr << "Can't open metrics file!";
+		metrics_stream << "elapsed_ms;bytes;hashed;inserted;mb_per_s;eta_s\n";
+	}
+	Time start_time= start_timer();
+	double last_time= 0;
+	uint64_t last_bytes= 0;
+	while (!progress_stop) {
+		this_thread::sleep_for(chrono::milliseconds(min(PROGRESS_MS, 100)));
+		double t= get_elapsed_time(start_time);
+		if (t - last_time < PROGRESS_MS) continue;
+		uint64_t bytes= progress_bytes.load(memory_order_relaxed);
+		uint64_t hashed= progress_hashed.load(memory_order_relaxed);
+		uint64_t inserted= progress_inserted.load(memory_order_relaxed);
+		double rate= (bytes - last_bytes) / (1000.0 * (t - last_time));		// [mega bytes / second]
+		double eta= (bytes > 0) ? (total_bytes - min(bytes, total_bytes)) * t / bytes / 1000.0 : -1;
+		printf("progress %7.1f s : %10.1f MB \t%6.1f MB/s (run %6.1f), inserted %llu, %4.1f%%, ETA %6.0f s \n",
+				t / 1000.0, bytes / 1e6, rate, bytes / (1000.0 * t), inserted, 100.0 * bytes / total_bytes, eta);
+		fflush(stdout);
+		if (METRICS_FILE) {
+			metrics_stream << (uint64_t)t << ";" << bytes << ";" << hashed << ";" << inserted << ";"
+					<< rate << ";" << eta << endl;
+		}
+		last_time= t;
+		last_bytes= bytes;
+	}
+}
+
 void rcp_generator(std::mt19937& mt_rand, uint8_t p[]) {
     std::uniform_int_distribution<uint8_t> dist(0, 255);
 	// p: random cyclic permutations (see Sattolo / FisherYates)
@@ -968,4 +1948,81 @@ void rcp_generator(std::mt19937& mt_rand, uint8_t p[]) {
 
 //	*********************************************************************************************************************************************
 
+// content-defined chunks
+// ----------------------
+uint64_t chunk_hash(const uint8_t s[], uint64_t size, uint64_t seed)
+{
+	uint64_t h= seed ^ (size * CRC_MIX);
+	uint64_t w;
+	uint64_t i= 0;
+	for (; i + 8 <= size; i+= 8) {
+		memcpy(&w, s + i, 8);
+		h= (h ^ w) * 0xFF51AFD7ED558CCDULL;
+		h^= h >> 32;
+	}
+	w= 0;
+	memcpy(&w, s + i, size - i);
+	h= (h ^ w) * 0xC4CEB9FE1A85EC53ULL;
+	return(h ^ (h >> 33));
+}
+
+void cdc_scan(
+	const uint8_t input_buffer[],	// input : bytes of the batch (shuffled, as in gather)
+	uint32_t size,					// input : batch size
+	bool last)						// input : last batch, the end of s closes the current chunk
+{
+	// worker1: a chunk ends where the top CDC_BITS of the gear hash are zero (CDC_MIN_SIZE .. CDC_MAX_SIZE bytes)
+	// (gear hash and length in registers, the bytes of a chunk are staged only across batch boundaries)
+	cdc_state &cs= reference_chunking;
+	uint64_t gear= cs.gear;
+	uint32_t length= cs.length;		// bytes of the current chunk (cs.length of them staged)
+	uint32_t from= 0;				// first byte of the current chunk in the batch
+	for (uint32_t j= 0; j < size; j++) {
+		if (length < CDC_MIN_SIZE - 64 && j < size - 1) {
+			// the first boundary test (length CDC_MIN_SIZE) depends on the last 64 bytes only
+			uint32_t k= min(CDC_MIN_SIZE - 64 - length, size - 1 - j);
+			length+= k;
+			j+= k - 1;
+			continue;
+		}
+		gear= (gear << 1) + GEAR_TABLE[input_buffer[j]];
+		length++;
+		if (!((length >= CDC_MIN_SIZE && (gear >> (64 - CDC_BITS)) == 0) || length == CDC_MAX_SIZE
+				|| (last && j == size - 1))) continue;
+		const uint8_t *bytes= input_buffer + from;
+		if (cs.length > 0) {
+			memcpy(cs.bytes + cs.length, bytes, j + 1 - from);
+			bytes= cs.bytes;
+		}
+		cdc_chunks.push_back({chunk_hash(bytes, length, 0), cs.start, length});
+		cs.start+= length;
+		cs.length= 0;
+		length= 0;
+		from= j + 1;
+	}
+	// stage the open chunk
+	memcpy(cs.bytes + cs.length, input_buffer + from, size - from);
+	cs.length= length;
+	cs.gear= gear;
+}
+
+uint64_t write_chunks(string file_name, time_t setup_time)
+{
+	// chunk file: magic, setup time, CDC_MIN_SIZE, CDC_MAX_SIZE, CDC_BITS, number of chunks, chunks (sorted by key)
+	qsort(cdc_chunks.data(), cdc_chunks.size(), sizeof(cdc_chunk), [](const void *a, const void *b){
+		const cdc_chunk *x= (const cdc_chunk *)a, *y= (const cdc_chunk *)b;
+		if (x->key != y->key) return (x->key > y->key) - (x->key < y->key);
+		return (x->offset > y->offset) - (x->offset < y->offset); });
+	uint64_t head[6]= {CDC_MAGIC, (uint64_t)setup_time, CDC_MIN_SIZE, CDC_MAX_SIZE, CDC_BITS, cdc_chunks.size()};
+	ofstream chunk_stream(file_name, ios::binary);
+	if (!chunk_stream) {
+		cerr << "Can't open chunk output file!";
+		exit(30);
+	}
+	chunk_stream.write((char *)head, sizeof(head));
+	chunk_stream.write((char *)cdc_chunks.data(), cdc_chunks.size() * sizeof(cdc_chunk));
+	chunk_stream.close();
+	return(cdc_chunks.size());
+}
+
 